@@ -9,6 +9,7 @@ import glob
 from datetime import datetime
 import re
 import pprint
+import hashlib
 from platformio.project.config import ProjectConfig
 
 
@@ -173,6 +174,52 @@ def generateMergedConfig(inFile,outFile,addFiles=[]):
         data=json.dumps(config,indent=2)
         writeFileIfChanged(outFile,data)
 
+def handleType(item):
+    '''the C++ type for the typed item handles'''
+    t=item.get('type')
+    if t == 'boolean':
+        return 'bool'
+    if t == 'number':
+        for k in ('default','min','max','step'):
+            v=item.get(k)
+            if v is not None and '.' in str(v):
+                return 'float'
+        return 'int'
+    return 'String'
+
+def cfgCheck(item,idx):
+    '''C++ definitions for the value check of an item (same rules as the web UI)
+       returns (definitions,name of the check) or (None,None)'''
+    t=item.get('type')
+    check=item.get('check')
+    clist=item.get('list')
+    if t in ('boolean','list'):
+        kind='GwConfigCheck::BOOLEAN' if t == 'boolean' else 'GwConfigCheck::LIST'
+        if clist is None:
+            if t == 'list':
+                return (None,None)
+            return ("static constexpr GwConfigCheck check_%d(%s);\n"%(idx,kind),"&check_%d"%idx)
+        values=[]
+        for v in clist:
+            if isinstance(v,dict):
+                v=v.get('v')
+            if isinstance(v,bool):
+                v='true' if v else 'false'
+            values.append('"%s"'%str(v).replace('"','\\"'))
+        data="static const char * const list_%d[]={%s,nullptr};\n"%(idx,",".join(values))
+        data+="static constexpr GwConfigCheck check_%d(%s,list_%d);\n"%(idx,kind,idx)
+        return (data,"&check_%d"%idx)
+    if t == 'number' and check in ('checkMinMax','checkPort'):
+        if check == 'checkPort':
+            vmin,vmax=1,65535
+        else:
+            vmin,vmax=item.get('min'),item.get('max')
+        return ("static constexpr GwConfigCheck check_%d(GwConfigCheck::NUMBER,nullptr,%s,%s,%s,%s);\n"%(
+            idx,
+            'false' if vmin is None else 'true', 0 if vmin is None else float(vmin),
+            'false' if vmax is None else 'true', 0 if vmax is None else float(vmax)),"&check_%d"%idx)
+    return (None,None)
+
 def generateCfg(inFile,outFile,impl):
     if not os.path.exists(inFile):
         raise Exception("unable to read cfg file %s"%inFile)
@@ -195,18 +242,36 @@ def generateCfg(inFile,outFile,impl):
                     raise Exception("%s: config names must be max 15 caracters"%n)
                 data+='  static constexpr const char* %s="%s";\n'%(n,n)
             data+="};\n"
+            data+='//typed handles (index into the config table) for direct access\n'
+            data+='namespace GwConfigHandles{\n'
+            for item in config:
+                n=item.get('name')
+                if n is None:
+                    continue
+                data+='  constexpr GwConfigHandle<%s> %s(%d);\n'%(handleType(item),n,idx)
+                idx+=1
+            data+="}\n"
         else:
-            data+='void GwConfigHandler::populateConfigs(GwConfigInterface **config){\n'
+            checks=""
+            populate=""
             for item in config:
                 name=item.get('name')
                 if name is None:
                     continue
-                data+='  configs[%d]='%(idx)
+                (cdef,cname)=cfgCheck(item,idx)
+                populate+='  configs[%d]='%(idx)
                 idx+=1
                 secret="false";
                 if item.get('type') == 'password':
                     secret="true"
-                data+="     new GwConfigInterface(%s,\"%s\",%s);\n"%(name,item.get('default'),secret)
+                if cdef is not None:
+                    checks+=cdef
+                    populate+="     new GwConfigInterface(%s,\"%s\",%s,GwConfigInterface::NORMAL,%s);\n"%(name,item.get('default'),secret,cname)
+                else:
+                    populate+="     new GwConfigInterface(%s,\"%s\",%s);\n"%(name,item.get('default'),secret)
+            data+=checks
+            data+='void GwConfigHandler::populateConfigs(GwConfigInterface **config){\n'
+            data+=populate
             data+='}\n'  
     writeFileIfChanged(outFile,data)    
                     
@@ -352,7 +417,7 @@ def genereateUserTasks(outfile):
 def generateEmbedded(elist,outFile):
     content=""
     for entry in elist:
-        content+="EMBED_GZ_FILE(\"%s\",%s,\"%s\");\n"%entry
+        content+="EMBED_GZ_FILE(\"%s\",%s,\"%s\",\"%s\");\n"%entry
     writeFileIfChanged(outFile,content)    
 
 def getContentType(fn):
@@ -512,12 +577,17 @@ def prebuild(env):
             pureName=pureName[0:-3]
         ct=getContentType(pureName)
         usname=ef.replace('/','_').replace('.','_')
-        filedefs.append((pureName,usname,ct))
         inFile=os.path.join(basePath(),"web",pureName)
         if os.path.exists(inFile):
             compressFile(inFile,ef)
         else:
             print("#WARNING: infile %s for %s not found"%(inFile,ef))
+        md5=""
+        efPath=os.path.join(basePath(),ef)
+        if os.path.exists(efPath):
+            with open(efPath,'rb') as eh:
+                md5=hashlib.md5(eh.read()).hexdigest()
+        filedefs.append((pureName,usname,ct,md5))
     generateEmbedded(filedefs,os.path.join(outPath(),EMBEDDED_INCLUDE))
     genereateUserTasks(os.path.join(outPath(), TASK_INCLUDE))
     generateFile(os.path.join(basePath(),XDR_FILE),os.path.join(outPath(),XDR_INCLUDE),generateXdrMappings)
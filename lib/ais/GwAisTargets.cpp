@@ -0,0 +1,629 @@
+#include "GwAisTargets.h"
+#include <N2kMessages.h>
+#include "GwJsonDocument.h"
+#include "GwMsgPack.h"
+#include "GwSynchronized.h"
+#include <esp_timer.h>
+#include <new>
+
+static_assert((GwAisTargets::INDEX_SIZE & (GwAisTargets::INDEX_SIZE-1)) == 0,"INDEX_SIZE must be a power of 2");
+static_assert(GwAisTargets::INDEX_SIZE >= 2*GwAisTargets::MAX_TARGETS,"INDEX_SIZE too small");
+static_assert(GwAisTargets::MAX_TARGETS < 32768,"MAX_TARGETS too big");
+
+static const double EARTH_RADIUS=6371000.0;
+static const double DEG_TO_RADIANS=M_PI/180.0;
+//below this relative speed (m/s) targets are considered to keep their distance
+static const double MIN_REL_SPEED=0.05;
+
+static inline uint32_t hashKey(uint32_t key){
+    key ^= key >> 16;
+    key *= 0x45d9f3b;
+    key ^= key >> 16;
+    return key;
+}
+static inline int homePos(uint32_t mmsi){
+    return hashKey(mmsi) & (GwAisTargets::INDEX_SIZE-1);
+}
+static inline float n2kToFloat(double v){
+    if (N2kIsNA(v)) return NAN;
+    return v;
+}
+static void copyString(char *dest,size_t size,const char *src){
+    strncpy(dest,src,size-1);
+    dest[size-1]=0;
+    //N2K and AIS pad with spaces or '@'
+    int len=strlen(dest);
+    while (len > 0 && (dest[len-1] == ' ' || dest[len-1] == '@')){
+        len--;
+        dest[len]=0;
+    }
+}
+
+GwAisTargets::GwAisTargets(){
+    lock=xSemaphoreCreateMutex();
+}
+GwAisTargets::~GwAisTargets(){
+    delete[] targets;
+    delete[] index;
+    vSemaphoreDelete(lock);
+}
+
+bool GwAisTargets::allocate(){
+    if (targets != nullptr) return true;
+    if (allocFailed) return false;
+    targets=new (std::nothrow) Target[MAX_TARGETS];
+    index=new (std::nothrow) int16_t[INDEX_SIZE];
+    if (targets == nullptr || index == nullptr){
+        //do not retry on every message
+        allocFailed=true;
+        delete[] targets;
+        delete[] index;
+        targets=nullptr;
+        index=nullptr;
+        return false;
+    }
+    for (int i=0;i<INDEX_SIZE;i++) index[i]=-1;
+    for (int i=MAX_TARGETS-1;i>=0;i--){
+        targets[i].next=freeList;
+        freeList=i;
+    }
+    return true;
+}
+
+int GwAisTargets::findIndexPos(uint32_t mmsi) const{
+    int pos=homePos(mmsi);
+    for (int i=0;i<INDEX_SIZE;i++){
+        int16_t slot=index[pos];
+        if (slot < 0) return -1;
+        if (targets[slot].mmsi == mmsi) return pos;
+        pos=(pos+1) & (INDEX_SIZE-1);
+    }
+    return -1;
+}
+GwAisTargets::Target *GwAisTargets::find(uint32_t mmsi) const{
+    if (targets == nullptr) return nullptr;
+    int pos=findIndexPos(mmsi);
+    if (pos < 0) return nullptr;
+    return &targets[index[pos]];
+}
+
+void GwAisTargets::unlink(int16_t slot){
+    Target *t=&targets[slot];
+    if (t->prev >= 0) targets[t->prev].next=t->next;
+    else head=t->next;
+    if (t->next >= 0) targets[t->next].prev=t->prev;
+    else tail=t->prev;
+    t->prev=-1;
+    t->next=-1;
+}
+void GwAisTargets::pushFront(int16_t slot){
+    Target *t=&targets[slot];
+    t->prev=-1;
+    t->next=head;
+    if (head >= 0) targets[head].prev=slot;
+    head=slot;
+    if (tail < 0) tail=slot;
+}
+
+void GwAisTargets::remove(int16_t slot){
+    int pos=findIndexPos(targets[slot].mmsi);
+    unlink(slot);
+    targets[slot]=Target();
+    targets[slot].next=freeList;
+    freeList=slot;
+    numTargets--;
+    if (pos < 0) return;
+    //backward shift deletion to keep the probe sequences intact
+    int free=pos;
+    int current=pos;
+    while (true){
+        current=(current+1) & (INDEX_SIZE-1);
+        int16_t cslot=index[current];
+        if (cslot < 0) break;
+        int home=homePos(targets[cslot].mmsi);
+        //can the entry at current be moved to free?
+        bool move=(current > free)?(home <= free || home > current):(home <= free && home > current);
+        if (move){
+            index[free]=cslot;
+            free=current;
+        }
+    }
+    index[free]=-1;
+}
+
+GwAisTargets::Target *GwAisTargets::findOrCreate(uint32_t mmsi,unsigned long now){
+    if (! allocate()) return nullptr;
+    Target *rt=find(mmsi);
+    if (rt != nullptr) return rt;
+    if (numTargets >= MAX_TARGETS){
+        if (now - targets[tail].lastSeen > TARGET_TIMEOUT) expired++;
+        else evicted++;
+        remove(tail);
+    }
+    int16_t slot=freeList;
+    if (slot < 0) return nullptr;
+    freeList=targets[slot].next;
+    int pos=homePos(mmsi);
+    while (index[pos] >= 0){
+        pos=(pos+1) & (INDEX_SIZE-1);
+    }
+    index[pos]=slot;
+    rt=&targets[slot];
+    rt->mmsi=mmsi;
+    rt->lastSeen=now;
+    pushFront(slot);
+    numTargets++;
+    return rt;
+}
+
+void GwAisTargets::touch(Target *target,unsigned long now){
+    target->lastSeen=now;
+    target->version=++changeCounter;
+    int16_t slot=target-targets;
+    if (slot != head){
+        unlink(slot);
+        pushFront(slot);
+    }
+    updates++;
+}
+
+void GwAisTargets::setPosition(Target *target,double lat,double lon,double cog,double sog,double heading,unsigned long now){
+    if (! N2kIsNA(lat) && ! N2kIsNA(lon)){
+        target->lat=round(lat*1e7);
+        target->lon=round(lon*1e7);
+        target->hasPosition=true;
+        target->lastPosition=now;
+    }
+    target->cog=n2kToFloat(cog);
+    target->sog=n2kToFloat(sog);
+    target->heading=n2kToFloat(heading);
+    target->dirty=true;
+}
+
+bool GwAisTargets::handleMessage(const tN2kMsg &msg){
+    unsigned long now=millis();
+    uint8_t messageId;
+    tN2kAISRepeat repeat;
+    uint32_t mmsi;
+    tN2kAISTransceiverInformation info;
+    uint8_t sid;
+    switch(msg.PGN){
+        case 129038UL:
+        {
+            double lat,lon,cog,sog,heading,rot;
+            bool accuracy,raim;
+            uint8_t seconds;
+            tN2kAISNavStatus navStatus;
+            messageId=1;
+            if (! ParseN2kPGN129038(msg,messageId,repeat,mmsi,lat,lon,accuracy,raim,seconds,
+                cog,sog,heading,rot,navStatus,info,sid)) return true;
+            GWSYNCHRONIZED(lock);
+            Target *t=findOrCreate(mmsi,now);
+            if (t == nullptr) return true;
+            t->targetClass=CLASS_A;
+            t->navStatus=navStatus;
+            setPosition(t,lat,lon,cog,sog,heading,now);
+            touch(t,now);
+            return true;
+        }
+        case 129039UL:
+        {
+            double lat,lon,cog,sog,heading;
+            bool accuracy,raim,display,dsc,band,msg22,state;
+            uint8_t seconds;
+            tN2kAISUnit unit;
+            tN2kAISMode mode;
+            if (! ParseN2kPGN129039(msg,messageId,repeat,mmsi,lat,lon,accuracy,raim,seconds,
+                cog,sog,info,heading,unit,display,dsc,band,msg22,mode,state,sid)) return true;
+            GWSYNCHRONIZED(lock);
+            Target *t=findOrCreate(mmsi,now);
+            if (t == nullptr) return true;
+            t->targetClass=CLASS_B;
+            setPosition(t,lat,lon,cog,sog,heading,now);
+            touch(t,now);
+            return true;
+        }
+        case 129041UL:
+        {
+            tN2kAISAtoNReportData data;
+            if (! ParseN2kPGN129041(msg,data)) return true;
+            GWSYNCHRONIZED(lock);
+            Target *t=findOrCreate(data.UserID,now);
+            if (t == nullptr) return true;
+            t->targetClass=ATON;
+            setPosition(t,data.Latitude,data.Longitude,N2kDoubleNA,N2kDoubleNA,N2kDoubleNA,now);
+            copyString(t->name,sizeof(t->name),data.AtoNName);
+            t->length=n2kToFloat(data.Length);
+            t->beam=n2kToFloat(data.Beam);
+            t->shipType=data.AtoNType;
+            touch(t,now);
+            return true;
+        }
+        case 129794UL:
+        {
+            //type 5
+            uint32_t imo;
+            char callsign[8];
+            char name[21];
+            char destination[21];
+            uint8_t vesselType;
+            double length,beam,posRefStbd,posRefBow,etaTime,draught;
+            uint16_t etaDate;
+            tN2kAISVersion aisVersion;
+            tN2kGNSStype gnssType;
+            tN2kAISDTE dte;
+            if (! ParseN2kPGN129794(msg,messageId,repeat,mmsi,imo,callsign,sizeof(callsign),name,sizeof(name),vesselType,
+                length,beam,posRefStbd,posRefBow,etaDate,etaTime,draught,destination,sizeof(destination),
+                aisVersion,gnssType,dte,info,sid)) return true;
+            GWSYNCHRONIZED(lock);
+            Target *t=findOrCreate(mmsi,now);
+            if (t == nullptr) return true;
+            t->targetClass=CLASS_A;
+            t->imo=imo;
+            copyString(t->callsign,sizeof(t->callsign),callsign);
+            copyString(t->name,sizeof(t->name),name);
+            copyString(t->destination,sizeof(t->destination),destination);
+            t->shipType=vesselType;
+            t->length=n2kToFloat(length);
+            t->beam=n2kToFloat(beam);
+            t->draught=n2kToFloat(draught);
+            touch(t,now);
+            return true;
+        }
+        case 129809UL:
+        {
+            //type 24A
+            char name[21];
+            if (! ParseN2kPGN129809(msg,messageId,repeat,mmsi,name,sizeof(name),info,sid)) return true;
+            GWSYNCHRONIZED(lock);
+            Target *t=findOrCreate(mmsi,now);
+            if (t == nullptr) return true;
+            if (t->targetClass == UNKNOWN) t->targetClass=CLASS_B;
+            copyString(t->name,sizeof(t->name),name);
+            touch(t,now);
+            return true;
+        }
+        case 129810UL:
+        {
+            //type 24B
+            uint8_t vesselType;
+            char vendor[4];
+            char callsign[8];
+            double length,beam,posRefStbd,posRefBow;
+            uint32_t mothership;
+            if (! ParseN2kPGN129810(msg,messageId,repeat,mmsi,vesselType,vendor,sizeof(vendor),callsign,sizeof(callsign),
+                length,beam,posRefStbd,posRefBow,mothership,info,sid)) return true;
+            GWSYNCHRONIZED(lock);
+            Target *t=findOrCreate(mmsi,now);
+            if (t == nullptr) return true;
+            if (t->targetClass == UNKNOWN) t->targetClass=CLASS_B;
+            copyString(t->callsign,sizeof(t->callsign),callsign);
+            t->shipType=vesselType;
+            t->length=n2kToFloat(length);
+            t->beam=n2kToFloat(beam);
+            touch(t,now);
+            return true;
+        }
+        default:
+            break;
+    }
+    return false;
+}
+
+void GwAisTargets::computeTarget(Target *target,unsigned long now){
+    target->dirty=false;
+    if (! target->hasPosition || ! ownValid){
+        target->distance=NAN;
+        target->bearing=NAN;
+        target->cpa=NAN;
+        target->tcpa=NAN;
+        return;
+    }
+    //local flat projection around own ship, good enough for AIS ranges
+    double cosLat=cos(ownLat*DEG_TO_RADIANS);
+    double dy=(target->getLat()-ownLat)*DEG_TO_RADIANS*EARTH_RADIUS;
+    double dx=(target->getLon()-ownLon)*DEG_TO_RADIANS*EARTH_RADIUS*cosLat;
+    //the position is older than now - move it forward
+    if (! isnan(target->sog) && ! isnan(target->cog)){
+        double age=(double)(now-target->lastPosition)/1000.0;
+        dx+=sin(target->cog)*target->sog*age;
+        dy+=cos(target->cog)*target->sog*age;
+    }
+    double distance=sqrt(dx*dx+dy*dy);
+    double bearing=atan2(dx,dy);
+    if (bearing < 0) bearing+=2*M_PI;
+    target->distance=distance;
+    target->bearing=bearing;
+    target->cpaTime=now;
+    cpaComputed++;
+    if (isnan(target->sog) || isnan(target->cog)){
+        if (target->targetClass != ATON){
+            target->cpa=NAN;
+            target->tcpa=NAN;
+            return;
+        }
+    }
+    double tvx=0,tvy=0;
+    if (! isnan(target->sog) && ! isnan(target->cog)){
+        tvx=sin(target->cog)*target->sog;
+        tvy=cos(target->cog)*target->sog;
+    }
+    double vx=tvx-sin(ownCog)*ownSog;
+    double vy=tvy-cos(ownCog)*ownSog;
+    double v2=vx*vx+vy*vy;
+    if (v2 < MIN_REL_SPEED*MIN_REL_SPEED){
+        target->cpa=distance;
+        target->tcpa=0;
+        return;
+    }
+    double tcpa=-(dx*vx+dy*vy)/v2;
+    target->tcpa=tcpa;
+    if (tcpa <= 0){
+        target->cpa=distance;
+        return;
+    }
+    double cx=dx+vx*tcpa;
+    double cy=dy+vy*tcpa;
+    target->cpa=sqrt(cx*cx+cy*cy);
+}
+
+void GwAisTargets::update(GwBoatData *boatData){
+    if (targets == nullptr) return;
+    unsigned long now=millis();
+    bool valid=boatData->LAT->isValid(now) && boatData->LON->isValid(now);
+    unsigned long version=boatData->LAT->getVersion()+boatData->LON->getVersion()+
+        boatData->COG->getVersion()+boatData->SOG->getVersion();
+    GWSYNCHRONIZED(lock);
+    int64_t start=esp_timer_get_time();
+    bool ownChanged=(valid != ownValid) || (valid && version != ownVersion);
+    ownValid=valid;
+    ownVersion=version;
+    if (valid){
+        ownLat=boatData->LAT->getData();
+        ownLon=boatData->LON->getData();
+        ownCog=boatData->COG->getDataWithDefault(0);
+        ownSog=boatData->SOG->getDataWithDefault(0);
+    }
+    while (tail >= 0 && (now - targets[tail].lastSeen) > TARGET_TIMEOUT){
+        expired++;
+        remove(tail);
+    }
+    for (int16_t slot=head;slot >= 0;slot=targets[slot].next){
+        Target *t=&targets[slot];
+        if (ownChanged || t->dirty){
+            computeTarget(t,now);
+            t->version=++changeCounter;
+        }
+    }
+    lastComputeUs=esp_timer_get_time()-start;
+}
+
+void GwAisTargets::setThinning(unsigned long interval,float tcpa){
+    GWSYNCHRONIZED(lock);
+    thinInterval=interval;
+    thinTcpa=tcpa;
+}
+
+bool GwAisTargets::positionMmsi(const tN2kMsg &msg,uint32_t &mmsi){
+    if (msg.PGN != 129038UL && msg.PGN != 129039UL) return false;
+    if (msg.DataLen < 5) return false;
+    mmsi=(uint32_t)msg.Data[1] | ((uint32_t)msg.Data[2] << 8) |
+        ((uint32_t)msg.Data[3] << 16) | ((uint32_t)msg.Data[4] << 24);
+    return true;
+}
+
+static inline int sixBit(char c){
+    int v=c-48;
+    if (v > 40) v-=8;
+    if (v < 0 || v > 63) return -1;
+    return v;
+}
+
+bool GwAisTargets::positionMmsi(const char *nmea,uint32_t &mmsi){
+    //!AIVDM,1,1,,A,payload,0*hh
+    if (nmea[0] != '!' || nmea[1] == 0 || nmea[2] == 0) return false;
+    if (strncmp(nmea+3,"VDM,1,",6) != 0) return false;
+    const char *payload=nmea+3;
+    for (int i=0;i<5;i++){
+        payload=strchr(payload,',');
+        if (payload == nullptr) return false;
+        payload++;
+    }
+    int type=sixBit(payload[0]);
+    if (type != 1 && type != 2 && type != 3 && type != 18 && type != 19 && type != 27) return false;
+    //mmsi: bits 8...37, chars 1..6 hold bits 6...41
+    uint64_t bits=0;
+    for (int i=1;i<=6;i++){
+        int v=sixBit(payload[i]);
+        if (v < 0) return false;
+        bits=(bits << 6) | v;
+    }
+    mmsi=(bits >> 4) & 0x3fffffff;
+    return true;
+}
+
+GwAisTargets::ThinInfo GwAisTargets::getThinInfo(const tN2kMsg &msg){
+    uint32_t mmsi;
+    if (! positionMmsi(msg,mmsi)) return ThinInfo();
+    return getThinInfo(mmsi,millis());
+}
+GwAisTargets::ThinInfo GwAisTargets::getThinInfo(const char *nmea){
+    uint32_t mmsi;
+    if (! positionMmsi(nmea,mmsi)) return ThinInfo();
+    return getThinInfo(mmsi,millis());
+}
+
+GwAisTargets::ThinInfo GwAisTargets::getThinInfo(uint32_t mmsi,unsigned long now){
+    ThinInfo rt;
+    rt.position=true;
+    rt.mmsi=mmsi;
+    GWSYNCHRONIZED(lock);
+    Target *t=find(mmsi);
+    if (t == nullptr || ! t->hasPosition || ! ownValid || isnan(t->distance)) return rt;
+    rt.known=true;
+    rt.distance=t->distance;
+    rt.cpa=t->cpa;
+    rt.moving=! isnan(t->sog) && t->sog >= THIN_MIN_SOG;
+    float tcpa=t->getTcpa(now);
+    rt.closing=! isnan(tcpa) && tcpa > 0 && tcpa <= thinTcpa;
+    unsigned long age=now-t->lastForward;
+    if (t->lastForward == 0 || age >= thinInterval){
+        t->lastForward=now;
+        rt.reduced=true;
+    }
+    else if (age < THIN_SAME_MESSAGE){
+        rt.reduced=true;
+    }
+    return rt;
+}
+
+bool GwAisTargets::getTarget(uint32_t mmsi, Target &target){
+    GWSYNCHRONIZED(lock);
+    Target *t=find(mmsi);
+    if (t == nullptr) return false;
+    target=*t;
+    return true;
+}
+
+int GwAisTargets::countSince(unsigned long since) const{
+    int rt=0;
+    for (int16_t slot=head;slot >= 0;slot=targets[slot].next){
+        if (targets[slot].version > since) rt++;
+    }
+    return rt;
+}
+
+static void setFloat(JsonObject &obj,const char *name,float v){
+    if (isnan(v)) return;
+    obj[name]=v;
+}
+
+String GwAisTargets::toJson(unsigned long since, int maxTargets, int start){
+    GWSYNCHRONIZED(lock);
+    unsigned long now=millis();
+    if (start < 0) start=0;
+    int num=0;
+    int next=-1;
+    if (targets != nullptr){
+        for (int slot=start;slot < MAX_TARGETS;slot++){
+            const Target *t=&targets[slot];
+            if (t->mmsi == 0 || t->version <= since) continue;
+            if (num >= maxTargets){
+                next=slot;
+                break;
+            }
+            num++;
+        }
+    }
+    GwJsonDocument json(JSON_OBJECT_SIZE(7)+JSON_OBJECT_SIZE(7)+JSON_ARRAY_SIZE(num)+num*JSON_OBJECT_SIZE(22));
+    json["version"]=changeCounter;
+    json["count"]=numTargets;
+    json["more"]=next >= 0;
+    if (next >= 0) json["next"]=next;
+    JsonObject stats=json.createNestedObject("stats");
+    stats["updates"]=updates;
+    stats["evicted"]=evicted;
+    stats["expired"]=expired;
+    stats["cpaComputed"]=cpaComputed;
+    stats["computeUs"]=lastComputeUs;
+    stats["max"]=(int)MAX_TARGETS;
+    stats["allocFailed"]=allocFailed;
+    JsonArray list=json.createNestedArray("targets");
+    int added=0;
+    if (targets != nullptr){
+        for (int slot=start;slot < MAX_TARGETS && added < num;slot++){
+            const Target *t=&targets[slot];
+            if (t->mmsi == 0 || t->version <= since) continue;
+            JsonObject jt=list.createNestedObject();
+            jt["mmsi"]=t->mmsi;
+            jt["class"]=t->targetClass;
+            jt["age"]=now-t->lastSeen;
+            if (t->hasPosition){
+                jt["lat"]=t->getLat();
+                jt["lon"]=t->getLon();
+                jt["posAge"]=now-t->lastPosition;
+            }
+            setFloat(jt,"cog",t->cog);
+            setFloat(jt,"sog",t->sog);
+            setFloat(jt,"heading",t->heading);
+            if (t->targetClass == CLASS_A) jt["navStatus"]=t->navStatus;
+            //strings are not copied - we still hold the lock when serializing
+            if (t->name[0]) jt["name"]=(const char *)t->name;
+            if (t->callsign[0]) jt["callsign"]=(const char *)t->callsign;
+            if (t->destination[0]) jt["destination"]=(const char *)t->destination;
+            if (t->imo) jt["imo"]=t->imo;
+            if (t->shipType) jt["type"]=t->shipType;
+            setFloat(jt,"length",t->length);
+            setFloat(jt,"beam",t->beam);
+            setFloat(jt,"draught",t->draught);
+            setFloat(jt,"distance",t->distance);
+            setFloat(jt,"bearing",t->bearing);
+            setFloat(jt,"cpa",t->cpa);
+            if (! isnan(t->tcpa)) jt["tcpa"]=t->getTcpa(now);
+            added++;
+        }
+    }
+    String buf;
+    serializeJson(json,buf);
+    return buf;
+}
+
+static const char * binaryFields[]={
+    "mmsi","class","age","lat","lon","cog","sog","heading","navStatus",
+    "name","callsign","type","length","beam","distance","bearing","cpa","tcpa"
+};
+static const int NUM_BINARY_FIELDS=sizeof(binaryFields)/sizeof(binaryFields[0]);
+
+static void writeFloat(GwMsgPackWriter &writer,float v){
+    if (isnan(v)) writer.nil();
+    else writer.f32(v);
+}
+
+void GwAisTargets::toBinary(std::vector<uint8_t> &out, unsigned long since){
+    GWSYNCHRONIZED(lock);
+    unsigned long now=millis();
+    int num=(targets != nullptr)?countSince(since):0;
+    GwMsgPackWriter writer(out);
+    out.reserve(64+NUM_BINARY_FIELDS*10+num*90);
+    writer.map(3);
+    writer.str("v");
+    writer.uint(changeCounter);
+    writer.str("f");
+    writer.array(NUM_BINARY_FIELDS);
+    for (int i=0;i<NUM_BINARY_FIELDS;i++){
+        writer.str(binaryFields[i]);
+    }
+    writer.str("t");
+    writer.array(num);
+    if (num == 0) return;
+    for (int16_t slot=head;slot >= 0;slot=targets[slot].next){
+        const Target *t=&targets[slot];
+        if (t->version <= since) continue;
+        writer.array(NUM_BINARY_FIELDS);
+        writer.uint(t->mmsi);
+        writer.uint(t->targetClass);
+        writer.uint(now-t->lastSeen);
+        if (t->hasPosition){
+            writer.f64(t->getLat());
+            writer.f64(t->getLon());
+        }
+        else{
+            writer.nil();
+            writer.nil();
+        }
+        writeFloat(writer,t->cog);
+        writeFloat(writer,t->sog);
+        writeFloat(writer,t->heading);
+        writer.uint(t->navStatus);
+        writer.str(t->name);
+        writer.str(t->callsign);
+        writer.uint(t->shipType);
+        writeFloat(writer,t->length);
+        writeFloat(writer,t->beam);
+        writeFloat(writer,t->distance);
+        writeFloat(writer,t->bearing);
+        writeFloat(writer,t->cpa);
+        if (isnan(t->tcpa)) writer.nil();
+        else writer.f32(t->getTcpa(now));
+    }
+}
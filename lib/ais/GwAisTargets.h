@@ -0,0 +1,242 @@
+#ifndef _GWAISTARGETS_H
+#define _GWAISTARGETS_H
+#include <Arduino.h>
+#include <N2kMsg.h>
+#include <vector>
+#include "GwBoatData.h"
+
+#ifndef GW_AIS_MAX_TARGETS
+#define GW_AIS_MAX_TARGETS 512
+#endif
+
+/**
+ * table of AIS targets keyed by MMSI
+ * fed with the AIS PGNs (all AIS data we receive ends up as N2K,
+ * 0183 AIS is converted before)
+ * fixed capacity: targets are kept in an array that is allocated once
+ * (on the first AIS message), the MMSI index uses open addressing
+ * if the table is full the least recently updated target is evicted
+ * CPA/TCPA against own ship is only recomputed for targets that changed,
+ * all targets are only recomputed if the own ship data changes
+ */
+class GwAisTargets{
+    public:
+        static const int MAX_TARGETS=GW_AIS_MAX_TARGETS;
+        //targets per JSON page (default and limit)
+        //one target needs ~350 bytes in the document and as much again serialized
+        static const int JSON_PAGE=25;
+        static const int MAX_JSON_PAGE=50;
+        //power of 2, at least twice MAX_TARGETS
+        static const int INDEX_SIZE=2048;
+        //targets without any update are removed after this time
+        static const unsigned long TARGET_TIMEOUT=10*60*1000;
+        typedef enum{
+            UNKNOWN=0,
+            CLASS_A=1,
+            CLASS_B=2,
+            ATON=3
+        } TargetClass;
+        class Target{
+            public:
+            uint32_t mmsi=0;
+            uint32_t imo=0;
+            //1e-7 deg, like N2K
+            int32_t lat=0;
+            int32_t lon=0;
+            float cog=NAN;     //rad
+            float sog=NAN;     //m/s
+            float heading=NAN; //rad
+            float length=NAN;  //m
+            float beam=NAN;    //m
+            float draught=NAN; //m
+            //own ship relative, NAN if unknown
+            float distance=NAN;//m
+            float bearing=NAN; //rad
+            float cpa=NAN;     //m
+            float tcpa=NAN;    //s at cpaTime, negative if already passed
+            unsigned long cpaTime=0;
+            unsigned long lastSeen=0;
+            unsigned long lastPosition=0;
+            unsigned long version=0;
+            //last position report passed by the thinning at reduced rate
+            unsigned long lastForward=0;
+            char name[21];
+            char callsign[8];
+            char destination[21];
+            uint8_t targetClass=UNKNOWN;
+            uint8_t navStatus=15;
+            uint8_t shipType=0;
+            bool hasPosition=false;
+            bool dirty=false;
+            //LRU list (free list for unused entries), -1 for none
+            int16_t prev=-1;
+            int16_t next=-1;
+            Target(){
+                name[0]=0;
+                callsign[0]=0;
+                destination[0]=0;
+            }
+            double getLat() const{ return lat*1e-7;}
+            double getLon() const{ return lon*1e-7;}
+            /**
+             * tcpa at the given time
+             */
+            float getTcpa(unsigned long now) const{
+                return tcpa-(float)(now-cpaTime)/1000.0;
+            }
+    };
+        /**
+         * thinning relevant data for one AIS position report
+         * computed once per message, each output decides with its own range
+         */
+        class ThinInfo{
+            public:
+            //the message is a position report of this mmsi
+            bool position=false;
+            uint32_t mmsi=0;
+            //target and own ship position known
+            bool known=false;
+            bool moving=false;
+            //TCPA within the closing limit
+            bool closing=false;
+            //the reduced rate interval for this target has elapsed
+            bool reduced=false;
+            float distance=NAN; //m
+            float cpa=NAN;      //m
+        };
+        //messages for the same target within this time (ms) share the decision
+        //(e.g. the raw 0183 and the converted N2K message)
+        static const unsigned long THIN_SAME_MESSAGE=100;
+        //below this speed (m/s, 0.5kn) targets are stationary
+        static constexpr float THIN_MIN_SOG=0.26;
+        /**
+         * get the MMSI if this is a position report (PGN 129038/129039)
+         */
+        static bool positionMmsi(const tN2kMsg &msg,uint32_t &mmsi);
+        /**
+         * get the MMSI if this is a single sentence !xxVDM
+         * position report (types 1,2,3,18,19,27)
+         */
+        static bool positionMmsi(const char *nmea,uint32_t &mmsi);
+    private:
+        Target *targets=nullptr;
+        int16_t *index=nullptr;
+        int numTargets=0;
+        //most recently updated
+        int16_t head=-1;
+        //least recently updated
+        int16_t tail=-1;
+        int16_t freeList=-1;
+        unsigned long changeCounter=0;
+        SemaphoreHandle_t lock;
+        bool ownValid=false;
+        double ownLat=0;
+        double ownLon=0;
+        double ownCog=0;
+        double ownSog=0;
+        unsigned long ownVersion=0;
+        //statistics
+        unsigned long updates=0;
+        unsigned long evicted=0;
+        unsigned long expired=0;
+        unsigned long cpaComputed=0;
+        unsigned long lastComputeUs=0;
+        bool allocFailed=false;
+        unsigned long thinInterval=30000;
+        float thinTcpa=20*60;
+        bool allocate();
+        int findIndexPos(uint32_t mmsi) const;
+        Target *find(uint32_t mmsi) const;
+        Target *findOrCreate(uint32_t mmsi,unsigned long now);
+        void remove(int16_t slot);
+        void unlink(int16_t slot);
+        void pushFront(int16_t slot);
+        void touch(Target *target,unsigned long now);
+        void computeTarget(Target *target,unsigned long now);
+        void setPosition(Target *target,double lat,double lon,double cog,double sog,double heading,unsigned long now);
+        int countSince(unsigned long since) const;
+    public:
+        GwAisTargets();
+        ~GwAisTargets();
+        /**
+         * handle a N2K message
+         * returns true if this was an AIS PGN
+         */
+        bool handleMessage(const tN2kMsg &msg);
+        /**
+         * fetch own ship data from the boat data and
+         * recompute CPA/TCPA for all changed targets
+         * also removes timed out targets
+         */
+        void update(GwBoatData *boatData);
+        /**
+         * @param interval ms between position reports of far or stationary targets
+         * @param tcpa s, targets with a lower positive TCPA are considered closing
+         */
+        void setThinning(unsigned long interval,float tcpa);
+        /**
+         * thinning info for a message
+         * fills position=false for anything that is not a position report
+         * calls for the same report must be done within THIN_SAME_MESSAGE
+         */
+        ThinInfo getThinInfo(const tN2kMsg &msg);
+        ThinInfo getThinInfo(const char *nmea);
+        ThinInfo getThinInfo(uint32_t mmsi,unsigned long now);
+        /**
+         * copy of a target
+         * returns false if not found
+         */
+        bool getTarget(uint32_t mmsi,Target &target);
+        /**
+         * JSON with the targets changed after since, at most maxTargets
+         * {"version":n,"count":n,"more":b,"next":n,"targets":[{..}],"stats":{...}}
+         * targets are returned in table order beginning at slot start,
+         * if more is set, repeat with the same since and start=next,
+         * after the last page use the version of the first page as the next since
+         * (own ship changes re-version all targets, so the version does not
+         * give a stable order for paging)
+         * units like the boat data: deg for lat/lon, rad, m/s, m, s
+         */
+        String toJson(unsigned long since,int maxTargets,int start=0);
+        /**
+         * MessagePack with all targets changed after since
+         * map {"v":version,"f":[field names],"t":[[values in order of f],...]}
+         */
+        void toBinary(std::vector<uint8_t> &out,unsigned long since);
+        int getNumTargets() const{ return numTargets;}
+        unsigned long getVersion() const{ return changeCounter;}
+};
+
+/**
+ * per output AIS thinning
+ * position reports of targets within range that are moving or closing
+ * (low TCPA with a CPA within range) pass at full rate,
+ * far away or stationary targets only once per thinning interval
+ */
+class GwAisThinner{
+        float range=0; //m, 0: no thinning
+        unsigned long forwarded=0;
+        unsigned long suppressed=0;
+    public:
+        /**
+         * @param rangeNm range in nm, 0 to disable
+         */
+        void setRange(float rangeNm){
+            range=rangeNm > 0?rangeNm*1852.0:0;
+        }
+        bool isActive() const{ return range > 0;}
+        bool canPass(const GwAisTargets::ThinInfo &info){
+            if (range <= 0 || ! info.position) return true;
+            bool rt=true;
+            if (info.known && ! info.reduced){
+                bool near=info.distance < range;
+                rt=(near && info.moving) || (info.closing && info.cpa < range);
+            }
+            if (rt) forwarded++;
+            else suppressed++;
+            return rt;
+        }
+        unsigned long getForwarded() const{ return forwarded;}
+        unsigned long getSuppressed() const{ return suppressed;}
+};
+#endif
@@ -79,12 +79,18 @@ int PayloadBuffer::getSignedValue(int _iBits)
 /* unback string (6 bit characters) -- already cleans string (removes trailing '@' and trailing spaces) */
 std::string PayloadBuffer::getString(int _iNumBits)
 {
-  static thread_local std::array<char, 64> strdata;
+  char strdata[64 + 1];
+  size_t n = getString(_iNumBits, strdata, sizeof(strdata));
+  return std::string(strdata, n);
+}
 
+/* unback string into a fixed buffer (always zero terminated, truncated if too small) */
+size_t PayloadBuffer::getString(int _iNumBits, char *_pOutput, size_t _uOutputSize)
+{
   int iNumChars = _iNumBits / 6;
-  if (iNumChars > (int)strdata.size())
+  if (iNumChars > (int)_uOutputSize - 1)
   {
-    iNumChars = (int)strdata.size();
+    iNumChars = (int)_uOutputSize - 1;
   }
 
   int32_t iStartBitIndex = m_iBitIndex;
@@ -94,7 +100,7 @@ std::string PayloadBuffer::getString(int _iNumBits)
     unsigned int ch = getUnsignedValue(6);
     if (ch > 0) // stop on '@'
     {
-      strdata[i] = ASCII_CHARS[ch];
+      _pOutput[i] = ASCII_CHARS[ch];
     }
     else
     {
@@ -106,7 +112,7 @@ std::string PayloadBuffer::getString(int _iNumBits)
   // remove trailing spaces
   while (iNumChars > 0)
   {
-    if (ascii_isspace(strdata[iNumChars - 1]) == true)
+    if (ascii_isspace(_pOutput[iNumChars - 1]) == true)
     {
       iNumChars--;
     }
@@ -115,11 +121,12 @@ std::string PayloadBuffer::getString(int _iNumBits)
       break;
     }
   }
+  _pOutput[iNumChars] = 0;
 
   // make sure bit index is correct
   m_iBitIndex = iStartBitIndex + _iNumBits;
 
-  return std::string(strdata.data(), iNumChars);
+  return iNumChars;
 }
 
 /* convert payload to decimal (de-armour) and concatenate 6bit decimal values into payload buffer */
@@ -237,72 +244,67 @@ uint8_t AIS::crc(const StringRef &_strNmea)
 
 
 
-/* get a buffer to use for multi-line sentence decoding */
-std::unique_ptr<Buffer> MultiSentenceBufferStore::getBuffer()
-{
-  if (m_buffers.empty() == true)
-  {
-    return std::unique_ptr<Buffer>(new Buffer (0));
-  }
-  else
-  {
-    auto pBuf = std::move(m_buffers.back());
-    m_buffers.pop_back();
-    return pBuf;
-  }
-}
+MultiSentence::MultiSentence()
+  : m_iSourceId(0),
+    m_iSequenceId(0),
+    m_cChannel(0),
+    m_uStartTime(0),
+    m_iFragmentCount(0),
+    m_iFragmentNum(0),
+    m_uPayloadSize(0),
+    m_uHeaderSize(0),
+    m_uFooterSize(0),
+    m_lines{}
+{}
 
-/* return buffer to pool */
-void MultiSentenceBufferStore::returnBuffer(std::unique_ptr<Buffer> &_buffer)
+/* (re)start with the first fragment */
+void MultiSentence::start(int _iSourceId, int _iSequenceId, char _cChannel, uint32_t _uTimeMs,
+                          int _iFragmentCount, const StringRef &_strFragment,
+                          const StringRef &_strLine, const StringRef &_strHeader,
+                          const StringRef &_strFooter)
 {
-  _buffer->clear();
-  m_buffers.push_back(std::move(_buffer));
-}
+  reset();
+  m_iSourceId = _iSourceId;
+  m_iSequenceId = _iSequenceId;
+  m_cChannel = _cChannel;
+  m_uStartTime = _uTimeMs;
+  m_iFragmentCount = _iFragmentCount;
 
-
-
-MultiSentence::MultiSentence(int _iFragmentCount, const StringRef &_strFragment,
-                             const StringRef &_strLine, const StringRef &_strHeader,
-                             const StringRef &_strFooter,
-                             MultiSentenceBufferStore &_bufferStore)
-  : m_iFragmentCount(_iFragmentCount),
-    m_iFragmentNum(0),
-    m_vecLines(_iFragmentCount),
-    m_bufferStore(_bufferStore)
-{
-  // buffer payload
-  m_pPayloadBuffer = m_bufferStore.getBuffer();
-  m_strPayload = bufferString(m_pPayloadBuffer, _strFragment);
+  // buffer payload (fragment size is checked by the decoder)
+  m_uPayloadSize = std::min(_strFragment.size(), MAX_CHARS_PER_FRAGMENT);
+  memcpy(m_payload, _strFragment.data(), m_uPayloadSize);
 
   // buffer header and footer
-  m_strHeader = bufferString(_strHeader);
-  m_strFooter = bufferString(_strFooter);
+  m_uHeaderSize = std::min(_strHeader.size(), MAX_META_LENGTH);
+  memcpy(m_header, _strHeader.data(), m_uHeaderSize);
+  m_uFooterSize = std::min(_strFooter.size(), MAX_META_LENGTH);
+  memcpy(m_footer, _strFooter.data(), m_uFooterSize);
 
   // init first fragment
-  m_vecLines[0] = bufferString(_strLine);
+  storeLine(0, _strLine);
   m_iFragmentNum++;
 }
 
-MultiSentence::~MultiSentence()
+void MultiSentence::reset()
 {
-  // return buffers
-  m_bufferStore.returnBuffer(m_pPayloadBuffer);
-
-  for (auto &pBuf : m_metaBuffers)
-  {
-    m_bufferStore.returnBuffer(pBuf);
-  }
+  m_iFragmentCount = 0;
+  m_iFragmentNum = 0;
+  m_uPayloadSize = 0;
+  m_uHeaderSize = 0;
+  m_uFooterSize = 0;
 }
 
 bool MultiSentence::addFragment(int _iFragmentNum, const StringRef &_strFragment, const StringRef &_strLine)
 {
   // check that fragments are added in order (out of order is an error)
   if ( (_iFragmentNum <= m_iFragmentCount) &&
-       (m_iFragmentNum == _iFragmentNum - 1) )
+       (m_iFragmentNum == _iFragmentNum - 1) &&
+       (_strFragment.size() <= MAX_CHARS_PER_FRAGMENT) )
   {
     // append data
-    m_strPayload = bufferString(m_pPayloadBuffer, _strFragment);
-    m_vecLines[_iFragmentNum - 1] = bufferString(_strLine);
+    memcpy(m_payload + m_uPayloadSize, _strFragment.data(), _strFragment.size());
+    m_uPayloadSize += _strFragment.size();
+    storeLine(_iFragmentNum - 1, _strLine);
     m_iFragmentNum++;
 
     return true;
@@ -315,42 +317,35 @@ bool MultiSentence::addFragment(int _iFragmentNum, const StringRef &_strFragment
 
 bool MultiSentence::isComplete() const
 {
-  return m_iFragmentCount == m_iFragmentNum;
-}
-
-/* copies string view into internal buffer (adds to buffer) */
-StringRef MultiSentence::bufferString(const std::unique_ptr<Buffer> &_pBuffer, const StringRef &_str)
-{
-  // append to buffer and return new string ref to whole buffer
-  _pBuffer->append(_str.data(), _str.size());
-  return StringRef(_pBuffer->data(), _pBuffer->size());
+  return (m_iFragmentCount > 0) && (m_iFragmentCount == m_iFragmentNum);
 }
 
-/* copies string view into internal buffer (creates new buffer) */
-StringRef MultiSentence::bufferString(const StringRef &_str)
+/* copies a line into the internal buffer */
+void MultiSentence::storeLine(int _iIndex, const StringRef &_strLine)
 {
-  // get new buffer and append data
-  m_metaBuffers.push_back(m_bufferStore.getBuffer());
-  auto &pMetaBuffer = m_metaBuffers.back();
-  pMetaBuffer->append(_str.data(), _str.size());
-
-  // return new string ref to buffer
-  return StringRef(pMetaBuffer->data(), _str.size());
+  size_t uSize = std::min(_strLine.size(), MAX_LINE_LENGTH);
+  memcpy(m_lineData[_iIndex], _strLine.data(), uSize);
+  m_lines[_iIndex] = StringRef(m_lineData[_iIndex], uSize);
 }
 
 
 
 AisDecoder::AisDecoder(int _iIndex)
   : m_iIndex(_iIndex),
-    m_multiSentences{},
+    m_uFragmentTimeout(5000),
     m_msgCounts{},
     m_uTotalMessages(0),
     m_uTotalBytes(0),
     m_uCrcErrors(0),
     m_uDecodingErrors(0),
+    m_uOrphanedFragments(0),
+    m_uIncompleteMessages(0),
+    m_uTimedOutMessages(0),
+    m_uEvictedMessages(0),
     m_vecMsgCallbacks{}
 {
-  enableMsgTypes({});
+  m_vecSentences.reserve(MAX_MSG_FRAGMENTS);
+  enableMsgTypes((uint32_t)0);
 }
 
 
@@ -372,10 +367,10 @@ void AisDecoder::setMsgCallback(int _iType, pfnMsgCallback _pfnCb, bool _bEnable
 }
 
 /* enable/disable msg callback */
-void AisDecoder::setMsgCallback(int _iType, pfnMsgCallback _pfnCb, const std::set<int> &_enabledTypes)
+void AisDecoder::setMsgCallback(int _iType, pfnMsgCallback _pfnCb, uint32_t _uTypeMask)
 {
   // NOTE: some callbacks attach to multiple message types
-  setMsgCallback(_iType, _pfnCb, (_enabledTypes.empty() == true) || (_enabledTypes.count(_iType) > 0));
+  setMsgCallback(_iType, _pfnCb, (_uTypeMask == 0) || ((_uTypeMask & (1UL << _iType)) != 0));
 }
 
 /*
@@ -383,6 +378,23 @@ void AisDecoder::setMsgCallback(int _iType, pfnMsgCallback _pfnCb, const std::se
   An empty set will enable all message types.
 */
 void AisDecoder::enableMsgTypes(const std::set<int> &_types)
+{
+  uint32_t uTypeMask = 0;
+  for (int iType : _types)
+  {
+    if ( (iType >= 0) && (iType < 32) )
+    {
+      uTypeMask |= 1UL << iType;
+    }
+  }
+  enableMsgTypes(uTypeMask);
+}
+
+/*
+  Enables which messages types to decode (bit n set enables type n).
+  A mask of 0 will enable all message types.
+*/
+void AisDecoder::enableMsgTypes(uint32_t _types)
 {
   setMsgCallback(1, &AisDecoder::decodeType123, _types);
   setMsgCallback(2, &AisDecoder::decodeType123, _types);
@@ -400,11 +412,11 @@ void AisDecoder::enableMsgTypes(const std::set<int> &_types)
 }
 
 /* decode Position Report (class A) */
-void AisDecoder::decodeType123(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits)
+const char *AisDecoder::decodeType123(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits)
 {
   if (_iPayloadSizeBits < 168)
   {
-    throw std::runtime_error("Invalid payload size.");
+    return "Invalid payload size.";
   }
 
   // decode message fields (binary buffer has to go through all fields, but some fields are not used)
@@ -425,14 +437,16 @@ void AisDecoder::decodeType123(PayloadBuffer &_buffer, unsigned int _uMsgType, i
   _buffer.getUnsignedValue(19);     // radio status
 
   onType123(_uMsgType, mmsi, navstatus, rot, sog, posAccuracy, posLon, posLat, cog, heading, Repeat, Raim, timestamp, maneuver_i);
+
+  return nullptr;
 }
 
 /* decode Base Station Report (type nibble already pulled from buffer) */
-void AisDecoder::decodeType411(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits)
+const char *AisDecoder::decodeType411(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits)
 {
   if (_iPayloadSizeBits < 168)
   {
-    throw std::runtime_error("Invalid payload size.");
+    return "Invalid payload size.";
   }
 
   // decode message fields (binary buffer has to go through all fields, but some fields are not used)
@@ -454,14 +468,16 @@ void AisDecoder::decodeType411(PayloadBuffer &_buffer, unsigned int _uMsgType, i
   _buffer.getUnsignedValue(19);    // radio status
 
   onType411(_uMsgType, mmsi, year, month, day, hour, minute, second, posAccuracy, posLon, posLat);
+
+  return nullptr;
 }
 
 /* decode Voyage Report (type nibble already pulled from buffer) */
-void AisDecoder::decodeType5(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits)
+const char *AisDecoder::decodeType5(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits)
 {
   if (_iPayloadSizeBits < 420)
   {
-    throw std::runtime_error("Invalid payload size.");
+    return "Invalid payload size.";
   }
 
   // decode message fields (binary buffer has to go through all fields, but some fields are not used)
@@ -469,8 +485,10 @@ void AisDecoder::decodeType5(PayloadBuffer &_buffer, unsigned int _uMsgType, int
   auto mmsi = _buffer.getUnsignedValue(30);
   auto ais_version = _buffer.getUnsignedValue(2);                 // AIS version
   auto imo = _buffer.getUnsignedValue(30);
-  auto callsign = _buffer.getString(42);
-  auto name = _buffer.getString(120);
+  char callsign[8];
+  _buffer.getString(42, callsign, sizeof(callsign));
+  char name[21];
+  _buffer.getString(120, name, sizeof(name));
   auto type = _buffer.getUnsignedValue(8);
   if (type > 99) {
     type = 0;
@@ -486,21 +504,24 @@ void AisDecoder::decodeType5(PayloadBuffer &_buffer, unsigned int _uMsgType, int
   auto etaHour = _buffer.getUnsignedValue(5);     // hour (0 - 23), 24 = N/A
   auto etaMinute = _buffer.getUnsignedValue(6);   // minute (0-59), 60 = N/A
   auto draught = _buffer.getUnsignedValue(8);
-  auto destination = _buffer.getString(120);
+  char destination[21];
+  _buffer.getString(120, destination, sizeof(destination));
 
   auto dte = _buffer.getBoolValue();                         // dte
   _buffer.getUnsignedValue(1);                    // spare
 
   onType5(_uMsgType, mmsi, imo, callsign, name, type, toBow, toStern, toPort, toStarboard, fixType, etaMonth, 
   etaDay, etaHour, etaMinute, draught, destination, ais_version, repeat, dte);
+
+  return nullptr;
 }
 
 /* decode Standard SAR Aircraft Position Report */
-void AisDecoder::decodeType9(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits)
+const char *AisDecoder::decodeType9(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits)
 {
   if (_iPayloadSizeBits < 168)
   {
-    throw std::runtime_error("Invalid payload size.");
+    return "Invalid payload size.";
   }
 
   // decode message fields (binary buffer has to go through all fields, but some fields are not used)
@@ -522,32 +543,37 @@ void AisDecoder::decodeType9(PayloadBuffer &_buffer, unsigned int _uMsgType, int
   _buffer.getUnsignedValue(20);    // radio status
 
   onType9(mmsi, sog, posAccuracy, posLon, posLat, cog, altitude);
+
+  return nullptr;
 }
 
 
 /* decode AIS safety related broadcast */
-void AisDecoder::decodeType14(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits)
+const char *AisDecoder::decodeType14(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits)
 {
   if (!(_iPayloadSizeBits > 40 && _iPayloadSizeBits < 1009))
   {
-    throw std::runtime_error("Invalid payload size.");
+    return "Invalid payload size.";
   }
   
   // decode message fields (binary buffer has to go through all fields, but some fields are not used)
   auto repeat =_buffer.getUnsignedValue(2);                 // repeatIndicator
   auto mmsi = _buffer.getUnsignedValue(30);
   _buffer.getUnsignedValue(2);  
-  auto text = _buffer.getString(_iPayloadSizeBits - 34 );
+  char text[64 + 1];   // safety text is capped at 64 characters
+  _buffer.getString(_iPayloadSizeBits - 34, text, sizeof(text));
   onType14(repeat, mmsi, text, _iPayloadSizeBits);
+
+  return nullptr;
 }
 
 
 /* decode Position Report (class B; type nibble already pulled from buffer) */
-void AisDecoder::decodeType18(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits)
+const char *AisDecoder::decodeType18(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits)
 {
   if (_iPayloadSizeBits < 168)
   {
-    throw std::runtime_error("Invalid payload size.");
+    return "Invalid payload size.";
   }
 
   // decode message fields (binary buffer has to go through all fields, but some fields are not used)
@@ -574,14 +600,16 @@ void AisDecoder::decodeType18(PayloadBuffer &_buffer, unsigned int _uMsgType, in
 
   onType18(_uMsgType, mmsi, sog, posAccuracy, posLon, posLat, cog, heading, raim, repeat, unit, 
     display, dsc, band, msg22, assigned, timestamp, state);
+
+  return nullptr;
 }
 
 /* decode Position Report (class B; type nibble already pulled from buffer) */
-void AisDecoder::decodeType19(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits)
+const char *AisDecoder::decodeType19(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits)
 {
   if (_iPayloadSizeBits < 312)
   {
-    throw std::runtime_error("Invalid payload size.");
+    return "Invalid payload size.";
   }
 
   // decode message fields (binary buffer has to go through all fields, but some fields are not used)
@@ -596,7 +624,8 @@ void AisDecoder::decodeType19(PayloadBuffer &_buffer, unsigned int _uMsgType, in
   auto heading = (int)_buffer.getUnsignedValue(9);
   auto timestamp = _buffer.getUnsignedValue(6);                 // timestamp
   _buffer.getUnsignedValue(4);                 // reserved
-  auto name = _buffer.getString(120);
+  char name[21];
+  _buffer.getString(120, name, sizeof(name));
   auto type = _buffer.getUnsignedValue(8);
   if (type > 99) {
     type = 0;
@@ -616,21 +645,24 @@ void AisDecoder::decodeType19(PayloadBuffer &_buffer, unsigned int _uMsgType, in
   onType19(mmsi, sog, posAccuracy, posLon, posLat, cog, 
   heading, name, type, toBow, toStern, toPort, toStarboard,
   timestamp, fixtype, dte, assigned, repeat, raim);
+
+  return nullptr;
 }
 
 /* decode Aid-to-Navigation Report */
-void AisDecoder::decodeType21(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits)
+const char *AisDecoder::decodeType21(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits)
 {
   if (_iPayloadSizeBits < 272)
   {
-    throw std::runtime_error("Invalid payload size.");
+    return "Invalid payload size.";
   }
 
   // decode message fields (binary buffer has to go through all fields, but some fields are not used)
   auto repeat=_buffer.getUnsignedValue(2);                 // repeatIndicator
   auto mmsi = _buffer.getUnsignedValue(30);
   auto aidType = _buffer.getUnsignedValue(5);
-  auto name = _buffer.getString(120);
+  char name[20 + 14 + 1];
+  size_t uNameLen = _buffer.getString(120, name, 21);
   auto posAccuracy = _buffer.getBoolValue();
   auto posLon = _buffer.getSignedValue(28);
   auto posLat = _buffer.getSignedValue(27);
@@ -648,19 +680,20 @@ void AisDecoder::decodeType21(PayloadBuffer &_buffer, unsigned int _uMsgType, in
   _buffer.getBoolValue();             // assigned mode
   _buffer.getUnsignedValue(1);        // spare
 
-  std::string nameExt;
   if (_iPayloadSizeBits > 272)
   {
-    nameExt = _buffer.getString(88);
+    _buffer.getString(88, name + uNameLen, sizeof(name) - uNameLen);
   }
 
-  onType21(mmsi, aidType, name + nameExt, posAccuracy, posLon, posLat, 
+  onType21(mmsi, aidType, name, posAccuracy, posLon, posLat, 
     toBow, toStern, toPort, toStarboard,
     repeat,timestamp, raim, virtualAton, offPosition);
+
+  return nullptr;
 }
 
 /* decode Voyage Report and Static Data (type nibble already pulled from buffer) */
-void AisDecoder::decodeType24(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits)
+const char *AisDecoder::decodeType24(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits)
 {
   // decode message fields (binary buffer has to go through all fields, but some fields are not used)
   auto repeat =_buffer.getUnsignedValue(2);                 // repeatIndicator
@@ -672,10 +705,11 @@ void AisDecoder::decodeType24(PayloadBuffer &_buffer, unsigned int _uMsgType, in
   {
     if (_iPayloadSizeBits < 160)
     {
-      throw std::runtime_error("Invalid payload size.");
+      return "Invalid payload size.";
     }
 
-    auto name = _buffer.getString(120);
+    char name[21];
+    _buffer.getString(120, name, sizeof(name));
     _buffer.getUnsignedValue(8);            // spare
 
     onType24A(_uMsgType, repeat, mmsi, name);
@@ -686,9 +720,7 @@ void AisDecoder::decodeType24(PayloadBuffer &_buffer, unsigned int _uMsgType, in
   {
     if (_iPayloadSizeBits < 168)
     {
-
-
-      throw std::runtime_error("Invalid payload size.");
+      return "Invalid payload size.";
     }
 
     auto type = _buffer.getUnsignedValue(8);
@@ -696,10 +728,12 @@ void AisDecoder::decodeType24(PayloadBuffer &_buffer, unsigned int _uMsgType, in
       type = 0;
     }
 
-    auto vendor = _buffer.getString(18);         // vendor ID
+    char vendor[4];
+    _buffer.getString(18, vendor, sizeof(vendor));  // vendor ID
     _buffer.getUnsignedValue(4);                 // unit model code
     _buffer.getUnsignedValue(20);                // serial number
-    auto callsign = _buffer.getString(42);
+    char callsign[8];
+    _buffer.getString(42, callsign, sizeof(callsign));
     auto toBow = _buffer.getUnsignedValue(9);
     auto toStern = _buffer.getUnsignedValue(9);
     auto toPort = _buffer.getUnsignedValue(6);
@@ -716,17 +750,18 @@ void AisDecoder::decodeType24(PayloadBuffer &_buffer, unsigned int _uMsgType, in
   // invalid part
   else
   {
-    throw std::runtime_error("Invalid part number.");
+    return "Invalid part number.";
   }
+
+  return nullptr;
 }
 
 /* decode Long Range AIS Broadcast message (type nibble already pulled from buffer) */
-void AisDecoder::decodeType27(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits)
+const char *AisDecoder::decodeType27(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits)
 {
   if (_iPayloadSizeBits < 96)
   {
-
-    throw std::runtime_error("Invalid payload size");
+    return "Invalid payload size.";
   }
 
   // decode message fields (binary buffer has to go through all fields, but some fields are not used)
@@ -746,10 +781,12 @@ void AisDecoder::decodeType27(PayloadBuffer &_buffer, unsigned int _uMsgType, in
   _buffer.getUnsignedValue(1);        // spare
 
   onType27(mmsi, navstatus, sog, posAccuracy, posLon, posLat, cog);
+
+  return nullptr;
 }
 
 /* decode Mobile AIS station message */
-void AisDecoder::decodeMobileAisMsg(const StringRef &_strPayload, int _iFillBits)
+const char *AisDecoder::decodeMobileAisMsg(const StringRef &_strPayload, int _iFillBits)
 {
   // de-armour string and back bits into buffer
   m_binaryBuffer.resetBitIndex();
@@ -761,8 +798,7 @@ void AisDecoder::decodeMobileAisMsg(const StringRef &_strPayload, int _iFillBits
   if ( (msgType == 0) ||
        (msgType > 27) )
   {
-
-
+    // reported, but not counted as decoding error
     onDecodeError(_strPayload, "Invalid message type.");
   }
   else
@@ -774,13 +810,28 @@ void AisDecoder::decodeMobileAisMsg(const StringRef &_strPayload, int _iFillBits
     auto pFnDecoder = m_vecMsgCallbacks[msgType];
     if (pFnDecoder != nullptr)
     {
-      (this->*pFnDecoder)(m_binaryBuffer, msgType, iBitsUsed);
+      return (this->*pFnDecoder)(m_binaryBuffer, msgType, iBitsUsed);
     }
     else
     {
       onNotDecoded(_strPayload, msgType);
     }
   }
+
+  return nullptr;
+}
+
+/* report the message and decode it, handles errors */
+void AisDecoder::processMessage(int _iFillBits)
+{
+  // NOTE: the order of the callbacks is important (supply RAW/META info first then decode message)
+  onMessage(m_strPayload, m_strHeader, m_strFooter);
+  const char *pError = decodeMobileAisMsg(m_strPayload, _iFillBits);
+  if (pError != nullptr)
+  {
+    m_uDecodingErrors++;
+    onDecodeError(m_strPayload, pError);
+  }
 }
 
 /* check sentence CRC */
@@ -846,6 +897,68 @@ bool AisDecoder::checkTalkerId(const StringRef &_strTalkerId)
 */
 size_t AisDecoder::decodeMsg(const char *_pNmeaBuffer, size_t _uBufferSize, size_t _uOffset, 
   const SentenceParser &_parser, bool treatAsComplete)
+{
+  return decodeMsg(_pNmeaBuffer, _uBufferSize, _uOffset, _parser, treatAsComplete, 0, 0);
+}
+
+/* drop incomplete multi-sentence messages older than the fragment timeout */
+void AisDecoder::expireMultiSentences(uint32_t _uTimeMs)
+{
+  for (auto &multiSentence : m_multiSentences)
+  {
+    if ( (multiSentence.isActive() == true) &&
+         ((_uTimeMs - multiSentence.startTime()) > m_uFragmentTimeout) )
+    {
+      m_uIncompleteMessages++;
+      m_uTimedOutMessages++;
+      multiSentence.reset();
+    }
+  }
+}
+
+/* find the multi-sentence slot for a source/sequence/channel */
+MultiSentence *AisDecoder::findMultiSentence(int _iSourceId, int _iSequenceId, char _cChannel)
+{
+  for (auto &multiSentence : m_multiSentences)
+  {
+    if (multiSentence.matches(_iSourceId, _iSequenceId, _cChannel) == true)
+    {
+      return &multiSentence;
+    }
+  }
+  
+  return nullptr;
+}
+
+/* get a free slot, evict the oldest message if all slots are in use */
+MultiSentence &AisDecoder::allocMultiSentence()
+{
+  MultiSentence *pOldest = nullptr;
+  for (auto &multiSentence : m_multiSentences)
+  {
+    if (multiSentence.isActive() == false)
+    {
+      return multiSentence;
+    }
+    
+    if ( (pOldest == nullptr) ||
+         ((int32_t)(multiSentence.startTime() - pOldest->startTime()) < 0) )
+    {
+      pOldest = &multiSentence;
+    }
+  }
+  
+  m_uIncompleteMessages++;
+  m_uEvictedMessages++;
+  pOldest->reset();
+  return *pOldest;
+}
+
+/*
+  Decode next sentence from a given source (see above).
+*/
+size_t AisDecoder::decodeMsg(const char *_pNmeaBuffer, size_t _uBufferSize, size_t _uOffset, 
+  const SentenceParser &_parser, bool treatAsComplete, int _iSourceId, uint32_t _uTimeMs)
 {
   // process and decode AIS strings
   StringRef strLine;
@@ -906,17 +1019,7 @@ size_t AisDecoder::decodeMsg(const char *_pNmeaBuffer, size_t _uBufferSize, size
             m_strPayload = m_words[5];
             m_vecSentences.push_back(strLine);
 
-            try
-            {
-              // NOTE: the order of the callbacks is important (supply RAW/META info first then decode message)
-              onMessage(m_strPayload, m_strHeader, m_strFooter);
-              decodeMobileAisMsg(m_strPayload, iFillBits);
-            }
-            catch (std::exception &ex)
-            {
-              m_uDecodingErrors++;
-              onDecodeError(m_strPayload, ex.what());
-            }
+            processMessage(iFillBits);
           }
 
           // build up multi-sentence payloads
@@ -924,9 +1027,12 @@ size_t AisDecoder::decodeMsg(const char *_pNmeaBuffer, size_t _uBufferSize, size
           {
             int iMsgId = strtoi(m_words[3]);
             int iFragmentNum = single_digit_strtoi(m_words[2]);
+            char cChannel = m_words[4].empty() ? 0 : m_words[4].data()[0];
+
+            expireMultiSentences(_uTimeMs);
 
             // check for valid message
-            if (iMsgId >= (int)m_multiSentences.size())
+            if ( (iMsgId < 0) || (iMsgId >= MAX_MSG_SEQUENCE_IDS) )
             {
               m_uDecodingErrors++;
               onDecodeError(strNmea, "Invalid message sequence id.");
@@ -942,65 +1048,70 @@ size_t AisDecoder::decodeMsg(const char *_pNmeaBuffer, size_t _uBufferSize, size
             // create multi-sentence object with first message
             else if (iFragmentNum == 1)
             {
-              m_multiSentences[iMsgId] = std::unique_ptr<MultiSentence>(new MultiSentence(iFragmentCount, m_words[5], strLine,
-                                         _parser.getHeader(strLine, strNmea),
-                                         _parser.getFooter(strLine, strNmea),
-                                         m_multiSentenceBuffers));
+              MultiSentence *pMultiSentence = findMultiSentence(_iSourceId, iMsgId, cChannel);
+              if (pMultiSentence != nullptr)
+              {
+                // restarted before the previous message was complete
+                m_uIncompleteMessages++;
+              }
+              else
+              {
+                pMultiSentence = &allocMultiSentence();
+              }
+              
+              pMultiSentence->start(_iSourceId, iMsgId, cChannel, _uTimeMs,
+                                    iFragmentCount, m_words[5], strLine,
+                                    _parser.getHeader(strLine, strNmea),
+                                    _parser.getFooter(strLine, strNmea));
             }
 
             // update multi-sentence object with more fragments
             else
             {
               // add to existing payload
-              auto &pMultiSentence = m_multiSentences[iMsgId];
+              MultiSentence *pMultiSentence = findMultiSentence(_iSourceId, iMsgId, cChannel);
               if (pMultiSentence != nullptr)
               {
+                auto &multiSentence = *pMultiSentence;
+                
                 // add new fragment and check for any message payload/fragment errors
-                bool bSuccess = pMultiSentence->addFragment(iFragmentNum, m_words[5], strLine);
+                bool bSuccess = multiSentence.addFragment(iFragmentNum, m_words[5], strLine);
 
                 if (bSuccess == true)
                 {
                   // check if all fragments have been received
-                  if (pMultiSentence->isComplete() == true)
+                  if (multiSentence.isComplete() == true)
                   {
                     // setup user data
-                    m_strHeader = pMultiSentence->header();
-                    m_strFooter = pMultiSentence->footer();
-                    m_vecSentences = pMultiSentence->sentences();
-                    m_strPayload = pMultiSentence->payload();
+                    m_strHeader = multiSentence.header();
+                    m_strFooter = multiSentence.footer();
+                    m_vecSentences.assign(multiSentence.sentences().begin(),
+                                          multiSentence.sentences().begin() + multiSentence.sentenceCount());
+                    m_strPayload = multiSentence.payload();
 
                     // decode whole payload and reset
-                    try
-                    {
-                      // NOTE: the order of the callbacks is important (supply RAW/META info first, then decode message)
-                      // NOTE: only uses META info of first line for multi-line messages
-                      onMessage(m_strPayload, m_strHeader, m_strFooter);
-                      decodeMobileAisMsg(m_strPayload, iFillBits);
-                    }
-                    catch (std::exception &ex)
-                    {
-                      m_uDecodingErrors++;
-                      onDecodeError(m_strPayload, ex.what());
-                    }
+                    // NOTE: only uses META info of first line for multi-line messages
+                    processMessage(iFillBits);
 
                     // cleanup
-                    m_multiSentences[iMsgId] = nullptr;
+                    multiSentence.reset();
                   }
                 }
                 else
                 {
                   // sentence error, so just reset
                   m_uDecodingErrors++;
-                  m_multiSentences[iMsgId] = nullptr;
+                  m_uIncompleteMessages++;
+                  multiSentence.reset();
                   onDecodeError(strNmea, "Multi-sentence decoding failed.");
                 }
               }
               else
               {
-                // sentence error, so just reset
+                // no first fragment for this source/sequence/channel
                 m_uDecodingErrors++;
-                m_multiSentences[iMsgId] = nullptr;
-                onDecodeError(strNmea, "Multi-sentence decoding failed.");
+                m_uOrphanedFragments++;
+                onDecodeError(strNmea, "Multi-sentence fragment without first fragment.");
               }
             }
           }
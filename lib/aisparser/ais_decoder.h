@@ -18,6 +18,8 @@ namespace AIS
     const char ASCII_CHARS[]                = "@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_ !\"#$%&'()*+,-./0123456789:;<=>?";
     const size_t MAX_FRAGMENTS              = 5;
     const size_t MAX_CHARS_PER_FRAGMENT     = 82;
+    const size_t MAX_LINE_LENGTH            = 100;      ///< longer lines are truncated when stored for multi-sentence messages
+    const size_t MAX_META_LENGTH            = 64;       ///< longer META headers/footers are truncated when stored for multi-sentence messages
     
     
     /**
@@ -26,7 +28,8 @@ namespace AIS
     class PayloadBuffer
     {
      private:
-        const static int MAX_PAYLOAD_SIZE = MAX_FRAGMENTS * MAX_CHARS_PER_FRAGMENT * 6 / 8 + 1;
+        /// de-armouring writes 8 byte words and reading may look 6 bytes ahead -- keep some padding
+        const static int MAX_PAYLOAD_SIZE = MAX_FRAGMENTS * MAX_CHARS_PER_FRAGMENT * 6 / 8 + 1 + 16;
         
      public:
         PayloadBuffer();
@@ -49,6 +52,9 @@ namespace AIS
         /// unback string (6 bit characters) -- already cleans string (removes trailing '@' and trailing spaces)
         std::string getString(int _iNumBits);
         
+        /// unback string into a fixed buffer (always zero terminated, truncated if too small; returns the string length)
+        size_t getString(int _iNumBits, char *_pOutput, size_t _uOutputSize);
+        
         unsigned char* getData(void) {
             return &m_data[0];
         }
@@ -67,43 +73,41 @@ namespace AIS
     
     
     
-    /**
-     Multi-sentence messages migth span across different source buffers and input (string views) has to be stored internally.
-     This class is a store of buffers for use by multi-sentence containers (see MultiSentence).
-     
-     */
-    class MultiSentenceBufferStore
-    {
-     public:
-        /// get a buffer to use for multi-line sentence decoding
-        std::unique_ptr<Buffer> getBuffer();
-        
-        /// return buffer to pool
-        void returnBuffer(std::unique_ptr<Buffer> &_buffer);
-
-     private:
-        std::vector<std::unique_ptr<Buffer>>    m_buffers;      ///< available buffers
-    };
-    
-    
     /**
      Multi-sentence message container.
      
      Multi-sentence messages migth span across different source buffers and the input has to be stored internally.
-     A buffer pool (see MultiSentenceBufferStore) is used to avoid memory allocations as far as possible when storing the
-     message data.
+     All data is copied into fixed size arrays, so a slot can be reused for the next message without any allocations.
+     A slot is identified by source id, sequence id and radio channel, so fragments from different receivers
+     (or channels) with the same sequence id do not mix.
+     Sentences and META data that do not fit are truncated (only used for reporting), fragments are checked
+     before they are added.
      
      */
     class MultiSentence
     {
      public:
-        /// constructor -- add first fragment
-        MultiSentence(int _iFragmentCount, const StringRef &_strFragment,
-                      const StringRef &_strLine,
-                      const StringRef &_strHeader, const StringRef &_strFooter,
-                      MultiSentenceBufferStore &_bufferStore);
+        MultiSentence();
+        
+        /// (re)start with the first fragment
+        void start(int _iSourceId, int _iSequenceId, char _cChannel, uint32_t _uTimeMs,
+                   int _iFragmentCount, const StringRef &_strFragment,
+                   const StringRef &_strLine,
+                   const StringRef &_strHeader, const StringRef &_strFooter);
+        
+        /// true if the slot is active and belongs to this source, sequence id and channel
+        bool matches(int _iSourceId, int _iSequenceId, char _cChannel) const {
+            return isActive() && (m_iSourceId == _iSourceId) && (m_iSequenceId == _iSequenceId) && (m_cChannel == _cChannel);
+        }
         
-        ~MultiSentence();
+        /// time of the first fragment
+        uint32_t startTime() const {return m_uStartTime;}
+        
+        /// free the slot
+        void reset();
+        
+        /// true if a message is currently being assembled
+        bool isActive() const {return m_iFragmentCount > 0;}
         
         /// add more fragments (returns false if there is an fragment indexing error)
         bool addFragment(int _iFragmentNum, const StringRef &_strFragment, const StringRef &_strLine);
@@ -112,34 +116,39 @@ namespace AIS
         bool isComplete() const;
         
         /// returns full payload
-        const StringRef &payload() const {return m_strPayload;}
+        StringRef payload() const {return StringRef(m_payload, m_uPayloadSize);}
         
-        /// returns full payload (ref stays valid only while this object exists and addFragment is not called)
-        const StringRef &header() const {return m_strHeader;}
+        /// returns META header of the first sentence (ref stays valid only while the slot is not reused)
+        StringRef header() const {return StringRef(m_header, m_uHeaderSize);}
         
-        /// returns full payload (ref stays valid only while this object exists and addFragment is not called)
-        const StringRef &footer() const {return m_strFooter;}
+        /// returns META footer of the first sentence (ref stays valid only while the slot is not reused)
+        StringRef footer() const {return StringRef(m_footer, m_uFooterSize);}
         
         /// returns original sentences referenced my this multi-line sentence
-        const std::vector<StringRef> &sentences() const {return m_vecLines;}
+        const std::array<StringRef, MAX_FRAGMENTS> &sentences() const {return m_lines;}
+        
+        /// number of sentences
+        int sentenceCount() const {return m_iFragmentNum;}
         
      private:
-        /// copies string view into internal buffer (adds to buffer)
-        StringRef bufferString(const std::unique_ptr<Buffer> &_pBuffer, const StringRef &_str);
+        /// copies a line into the internal buffer
+        void storeLine(int _iIndex, const StringRef &_strLine);
         
-        /// copies string view into internal buffer (creates new buffer)
-        StringRef bufferString(const StringRef &_str);
-
      protected:
+        int                                     m_iSourceId;
+        int                                     m_iSequenceId;
+        char                                    m_cChannel;
+        uint32_t                                m_uStartTime;
         int                                     m_iFragmentCount;
         int                                     m_iFragmentNum;
-        StringRef                               m_strHeader;
-        StringRef                               m_strFooter;
-        StringRef                               m_strPayload;
-        std::vector<StringRef>                  m_vecLines;
-        MultiSentenceBufferStore                &m_bufferStore;
-        std::vector<std::unique_ptr<Buffer>>    m_metaBuffers;
-        std::unique_ptr<Buffer>                 m_pPayloadBuffer;
+        char                                    m_payload[MAX_FRAGMENTS * MAX_CHARS_PER_FRAGMENT];
+        size_t                                  m_uPayloadSize;
+        char                                    m_header[MAX_META_LENGTH];
+        size_t                                  m_uHeaderSize;
+        char                                    m_footer[MAX_META_LENGTH];
+        size_t                                  m_uFooterSize;
+        char                                    m_lineData[MAX_FRAGMENTS][MAX_LINE_LENGTH];
+        std::array<StringRef, MAX_FRAGMENTS>    m_lines;
     };
     
     
@@ -211,12 +220,14 @@ namespace AIS
     {
      private:
         const static int MAX_MSG_SEQUENCE_IDS      = 10;       ///< max multi-sentience message sequences
+        const static int MAX_MULTI_SENTENCES       = 16;       ///< multi-sentence messages assembled at the same time (all sources)
         const static int MAX_MSG_TYPES             = 64;       ///< max message type count (unique messsage IDs)
         const static int MAX_MSG_PAYLOAD_LENGTH    = 82;       ///< max payload length (NMEA limit)
         const static int MAX_MSG_FRAGMENTS         = 5;        ///< maximum number of fragments/sentences a message can have
         const static int MAX_MSG_WORDS             = 10;       ///< maximum number of words per sentence
         
-        using pfnMsgCallback = void (AisDecoder::*)(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits);
+        /// decoding functions return an error text or nullptr on success
+        using pfnMsgCallback = const char *(AisDecoder::*)(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits);
 
      public:
         AisDecoder(int _iIndex = 0);
@@ -230,6 +241,12 @@ namespace AIS
          */
         void enableMsgTypes(const std::set<int> &_types);
         
+        /**
+            Enables which messages types to decode (bit n set enables type n).
+            A mask of 0 will enable all message types.
+         */
+        void enableMsgTypes(uint32_t _uTypeMask);
+        
         /**
             Decode next sentence (starts reading from input buffer with the specified offset; returns the number of bytes processed, or 0 when no more messages can be decoded).
             Has to be called until it returns 0, to ensure that any buffered multi-line strings are backed up properly.
@@ -237,6 +254,17 @@ namespace AIS
         size_t decodeMsg(const char *_pNmeaBuffer, size_t _uBufferSize, size_t _uOffset, 
             const SentenceParser &_parser, bool treatAsComplete=false);
         
+        /**
+            Decode a sentence from a given source.
+            Multi-sentence messages are assembled per source id, sequence id and channel.
+            _uTimeMs is used to drop incomplete multi-sentence messages after the fragment timeout.
+         */
+        size_t decodeMsg(const char *_pNmeaBuffer, size_t _uBufferSize, size_t _uOffset, 
+            const SentenceParser &_parser, bool treatAsComplete, int _iSourceId, uint32_t _uTimeMs);
+        
+        /// max time (ms) between the first and the last fragment of a multi-sentence message
+        void setFragmentTimeout(uint32_t _uTimeoutMs) {m_uFragmentTimeout = _uTimeoutMs;}
+        
         /// returns the total number of messages processed
         uint64_t getTotalMessageCount() const {return m_uTotalMessages;}
         
@@ -251,6 +279,18 @@ namespace AIS
         
         /// returns the total number of decoding errors
         uint64_t getDecodingErrorCount() const {return m_uDecodingErrors;}
+        
+        /// returns the number of fragments received without a matching first fragment
+        uint64_t getOrphanedFragmentCount() const {return m_uOrphanedFragments;}
+        
+        /// returns the number of multi-sentence messages that have been dropped before they were complete
+        uint64_t getIncompleteMessageCount() const {return m_uIncompleteMessages;}
+        
+        /// returns the number of incomplete multi-sentence messages dropped after the fragment timeout (included in incomplete)
+        uint64_t getTimedOutMessageCount() const {return m_uTimedOutMessages;}
+        
+        /// returns the number of incomplete multi-sentence messages dropped to free a slot (included in incomplete)
+        uint64_t getEvictedMessageCount() const {return m_uEvictedMessages;}
      
         
         // access to message info
@@ -276,14 +316,14 @@ namespace AIS
         virtual void onType123(unsigned int _uMsgType, unsigned int _uMmsi, unsigned int _uNavstatus, int _iRot, unsigned int _uSog, bool _bPosAccuracy, long _iPosLon, long _iPosLat, int _iCog, int _iHeading, int _Repeat, bool _Raim, unsigned int _timestamp, unsigned int _maneuver_i) = 0;
         virtual void onType411(unsigned int _uMsgType, unsigned int _uMmsi, unsigned int _uYear, unsigned int _uMonth, unsigned int _uDay, unsigned int _uHour, unsigned int _uMinute, unsigned int _uSecond,
                                bool _bPosAccuracy, int _iPosLon, int _iPosLat) = 0;
-        virtual void onType5(unsigned int _uMsgType, unsigned int _uMmsi, unsigned int _uImo, const std::string &_strCallsign, const std::string &_strName,
+        virtual void onType5(unsigned int _uMsgType, unsigned int _uMmsi, unsigned int _uImo, const char *_strCallsign, const char *_strName,
                              unsigned int _uType, unsigned int _uToBow, unsigned int _uToStern, unsigned int _uToPort, unsigned int _uToStarboard, unsigned int _uFixType,
                              unsigned int _uEtaMonth, unsigned int _uEtaDay, unsigned int _uEtaHour, unsigned int _uEtaMinute, unsigned int _uDraught,
-                             const std::string &_strDestination, unsigned int _ais_version, unsigned int _repeat, bool _dte) = 0;
+                             const char *_strDestination, unsigned int _ais_version, unsigned int _repeat, bool _dte) = 0;
         
         virtual void onType9(unsigned int _uMmsi, unsigned int _uSog, bool _bPosAccuracy, int _iPosLon, int _iPosLat, int _iCog, unsigned int _iAltitude) = 0;
 
-        virtual void onType14(unsigned int _repeat, unsigned int _uMmsi, const std::string &_strText, int _iPayloadSizeBits) = 0;
+        virtual void onType14(unsigned int _repeat, unsigned int _uMmsi, const char *_strText, int _iPayloadSizeBits) = 0;
         
         virtual void onType18(unsigned int _uMsgType, unsigned int _uMmsi, unsigned int _uSog, bool _bPosAccuracy, 
                                long _iPosLon, long _iPosLat, int _iCog, int _iHeading, bool _raim, unsigned int _repeat,
@@ -291,18 +331,18 @@ namespace AIS
                                unsigned int _timestamp, bool _state ) = 0;
         
         virtual void onType19(unsigned int _uMmsi, unsigned int _uSog, bool _bPosAccuracy, int _iPosLon, int _iPosLat, int _iCog, int _iHeading,
-                              const std::string &_strName, unsigned int _uType,
+                              const char *_strName, unsigned int _uType,
                               unsigned int _uToBow, unsigned int _uToStern, unsigned int _uToPort, 
                               unsigned int _uToStarboard, unsigned int timestamp, unsigned int fixtype, bool dte, 
                               bool assigned, unsigned int repeat, bool raim) = 0;
         
-        virtual void onType21(unsigned int _uMmsi, unsigned int _uAidType, const std::string &_strName, bool _bPosAccuracy, int _iPosLon, int _iPosLat,
+        virtual void onType21(unsigned int _uMmsi, unsigned int _uAidType, const char *_strName, bool _bPosAccuracy, int _iPosLon, int _iPosLat,
                               unsigned int _uToBow, unsigned int _uToStern, unsigned int _uToPort, unsigned int _uToStarboard, 
                               unsigned int repeat,unsigned int timestamp, bool raim, bool virtualAton, bool offPosition) = 0;
         
-        virtual void onType24A(unsigned int _uMsgType, unsigned int _repeat, unsigned int _uMmsi, const std::string &_strName) = 0;
+        virtual void onType24A(unsigned int _uMsgType, unsigned int _repeat, unsigned int _uMmsi, const char *_strName) = 0;
         
-        virtual void onType24B(unsigned int _uMsgType, unsigned int _repeat, unsigned int _uMmsi, const std::string &_strCallsign, unsigned int _uType, unsigned int _uToBow, unsigned int _uToStern, unsigned int _uToPort, unsigned int _uToStarboard, const std::string &_strVendor) = 0;
+        virtual void onType24B(unsigned int _uMsgType, unsigned int _repeat, unsigned int _uMmsi, const char *_strCallsign, unsigned int _uType, unsigned int _uToBow, unsigned int _uToStern, unsigned int _uToPort, unsigned int _uToStarboard, const char *_strVendor) = 0;
         
         virtual void onType27(unsigned int _uMmsi, unsigned int _uNavstatus, unsigned int _uSog, bool _bPosAccuracy, int _iPosLon, int _iPosLat, int _iCog) = 0;
         
@@ -316,17 +356,17 @@ namespace AIS
         virtual void onNotDecoded(const StringRef &_strPayload, int _iMsgType) = 0;
         
         /// called when any decoding error ocurred
-        virtual void onDecodeError(const StringRef &_strPayload, const std::string &_strError) = 0;
+        virtual void onDecodeError(const StringRef &_strPayload, const char *_strError) = 0;
         
         /// called when any parsing error ocurred
-        virtual void onParseError(const StringRef &_strLine, const std::string &_strError) = 0;
+        virtual void onParseError(const StringRef &_strLine, const char *_strError) = 0;
         
      private:
         /// enable/disable msg callback
         void setMsgCallback(int _iType, pfnMsgCallback _pfnCb, bool _bEnabled);
                             
         /// enable/disable msg callback
-        void setMsgCallback(int _iType, pfnMsgCallback _pfnCb, const std::set<int> &_enabledTypes);
+        void setMsgCallback(int _iType, pfnMsgCallback _pfnCb, uint32_t _uTypeMask);
         
         /// check sentence CRC
         bool checkCrc(const StringRef &_strPayload);
@@ -334,51 +374,63 @@ namespace AIS
         /// check talker id
         bool checkTalkerId(const StringRef &_strTalkerId);
         
-        /// decode Mobile AIS station message
-        void decodeMobileAisMsg(const StringRef &_strPayload, int _iFillBits);
+        /// decode Mobile AIS station message (returns an error text or nullptr)
+        const char *decodeMobileAisMsg(const StringRef &_strPayload, int _iFillBits);
+        
+        /// report the message and decode it, handles errors
+        void processMessage(int _iFillBits);
+        
+        /// drop incomplete multi-sentence messages older than the fragment timeout
+        void expireMultiSentences(uint32_t _uTimeMs);
+        
+        /// find the multi-sentence slot for a source/sequence/channel (nullptr if none)
+        MultiSentence *findMultiSentence(int _iSourceId, int _iSequenceId, char _cChannel);
+        
+        /// get a slot for a new multi-sentence message (evicts the oldest if all are in use)
+        MultiSentence &allocMultiSentence();
         
         /// decode Position Report (class A; type nibble already pulled from buffer)
-        void decodeType123(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits);
+        const char *decodeType123(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits);
         
         /// decode Base Station Report (type nibble already pulled from buffer; or, response to inquiry)
-        void decodeType411(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits);
+        const char *decodeType411(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits);
         
         /// decode Voyage Report and Static Data (type nibble already pulled from buffer)
-        void decodeType5(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits);
+        const char *decodeType5(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits);
         
         /// decode Standard SAR Aircraft Position Report
-        void decodeType9(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits);
+        const char *decodeType9(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits);
         
         /// decode Standard SAR Aircraft Position Report
-        void decodeType11(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits);
+        const char *decodeType11(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits);
 
         /// decode Safety related Broadcast Message
-        void decodeType14(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits);
+        const char *decodeType14(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits);
         
         /// decode Position Report (class B; type nibble already pulled from buffer)
-        void decodeType18(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits);
+        const char *decodeType18(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits);
         
         /// decode Position Report (class B; type nibble already pulled from buffer)
-        void decodeType19(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits);
+        const char *decodeType19(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits);
         
         /// decode Aid-to-Navigation Report
-        void decodeType21(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits);
+        const char *decodeType21(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits);
         
         /// decode Voyage Report and Static Data (type nibble already pulled from buffer)
-        void decodeType24(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits);
+        const char *decodeType24(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits);
         
         /// decode Long Range AIS Broadcast message (type nibble already pulled from buffer)
-        void decodeType27(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits);
+        const char *decodeType27(PayloadBuffer &_buffer, unsigned int _uMsgType, int _iPayloadSizeBits);
 
     private:
         int                                                                     m_iIndex;               ///< arbitrary id/index set by user for this decoder
         
         PayloadBuffer                                                           m_binaryBuffer;         ///< used internally to decode NMEA payloads
-        std::array<std::unique_ptr<MultiSentence>, MAX_MSG_SEQUENCE_IDS>        m_multiSentences;       ///< used internally to buffer multi-line message sentences
+        std::array<MultiSentence, MAX_MULTI_SENTENCES>                          m_multiSentences;       ///< used internally to buffer multi-line message sentences (fixed slots, no allocations)
+        uint32_t                                                                m_uFragmentTimeout;     ///< ms, incomplete multi-sentence messages are dropped after this
         std::array<StringRef, MAX_MSG_WORDS>                                    m_words;                ///< used internally to buffer NMEA words
-        MultiSentenceBufferStore                                                m_multiSentenceBuffers;
         
-        std::vector<StringRef>                                                  m_vecSentences;         ///< all NMEA/raw sentences for message - stored for each message just before user callbacks
+        std::vector<StringRef>                                                  m_vecSentences;         ///< all NMEA/raw sentences for message - stored for each message just before user callbacks (capacity reserved)
         StringRef                                                               m_strHeader;            ///< extracted META header
         StringRef                                                               m_strFooter;            ///< extracted META header
         StringRef                                                               m_strPayload;           ///< extracted full payload (concatenated fragments; ascii)
@@ -388,6 +440,10 @@ namespace AIS
         uint64_t                                                                m_uTotalBytes;
         uint64_t                                                                m_uCrcErrors;           ///< CRC check error count
         uint64_t                                                                m_uDecodingErrors;      ///< decoding error count (includes CRC errors)
+        uint64_t                                                                m_uOrphanedFragments;   ///< fragments without a first fragment
+        uint64_t                                                                m_uIncompleteMessages;  ///< multi-sentence messages dropped before complete
+        uint64_t                                                                m_uTimedOutMessages;    ///< incomplete messages dropped by timeout
+        uint64_t                                                                m_uEvictedMessages;     ///< incomplete messages dropped to free a slot
         
         std::array<pfnMsgCallback, 100>                                         m_vecMsgCallbacks;      ///< message decoding functions mapped to message IDs
     };
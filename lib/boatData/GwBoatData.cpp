@@ -2,6 +2,7 @@
 #include <GwJsonDocument.h>
 #include <ArduinoJson/Json/TextFormatter.hpp>
 #include "GWConfig.h"
+#include "GwMsgPack.h"
 #define GWTYPE_DOUBLE 1
 #define GWTYPE_UINT32 2
 #define GWTYPE_UINT16 3
@@ -73,8 +74,12 @@ void GwBoatItemBase::setInvalidTime(GwConfigHandler *cfg){
 }
 size_t GwBoatItemBase::getJsonSize() { return JSON_OBJECT_SIZE(10); }
 
+unsigned long GwBoatItemBase::changeCounter=0;
+
 void GwBoatItemBase::GwBoatItemMap::add(const String &name,GwBoatItemBase *item){
     boatData->setInvalidTime(item);
+    item->id=nextId;
+    nextId++;
     (*this)[name]=item;
 }
 
@@ -430,6 +435,56 @@ String GwBoatData::toJson() const
     serializeJson(json, buf);
     return buf;
 }
+void GwBoatData::toBinary(std::vector<uint8_t> &out, unsigned long since, bool withSchema) const
+{
+    unsigned long now = millis();
+    GwMsgPackWriter writer(out);
+    int numChanged = 0;
+    for (auto it = values.begin(); it != values.end(); it++)
+    {
+        if (it->second->getVersion() > since) numChanged++;
+    }
+    out.reserve(32 + numChanged * 24 + (withSchema ? values.size() * 32 : 0));
+    writer.map(withSchema ? 4 : 3);
+    writer.str("v");
+    writer.uint(GwBoatItemBase::getChangeCounter());
+    writer.str("s");
+    writer.uint(values.getSchemaVersion());
+    if (withSchema)
+    {
+        writer.str("schema");
+        writer.array(values.size());
+        for (auto it = values.begin(); it != values.end(); it++)
+        {
+            GwBoatItemBase *item = it->second;
+            writer.array(4);
+            writer.uint(item->getId());
+            writer.str(it->first);
+            writer.str(item->getFormat());
+            writer.uint(item->getInvalidTime());
+        }
+    }
+    writer.str("d");
+    writer.array(numChanged);
+    for (auto it = values.begin(); it != values.end(); it++)
+    {
+        GwBoatItemBase *item = it->second;
+        if (item->getVersion() <= since) continue;
+        writer.array(5);
+        writer.uint(item->getId());
+        if (item->getCurrentType() == GWTYPE_DOUBLE)
+        {
+            writer.f64(item->getDoubleValue());
+        }
+        else
+        {
+            writer.integer((int64_t)item->getDoubleValue());
+        }
+        writer.uint(now - item->getLastSet());
+        writer.integer(item->getLastSource());
+        writer.boolean(item->isValid(now));
+    }
+}
 String GwBoatData::toString()
 {
     String rt;
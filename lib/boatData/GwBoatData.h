@@ -70,9 +70,19 @@ class GwBoatItemBase{
             if (ts) lastSet=ts;
             else lastSet=millis();
             writer.reset(); //value has changed
+            version=++changeCounter;
         }
         int lastUpdateSource;
+        //stable id, assigned when added to the boat data
+        int id=-1;
+        //value of changeCounter at the last change
+        unsigned long version=0;
+        static unsigned long changeCounter;
     public:
+        int getId() const {return id;}
+        unsigned long getVersion() const {return version;}
+        static unsigned long getChangeCounter(){return changeCounter;}
+        unsigned long getInvalidTime() const {return invalidTime;}
         int getCurrentType(){return type;}
         unsigned long getLastSet() const {return lastSet;}
         bool isValid(unsigned long now=0) const ;
@@ -81,6 +91,7 @@ class GwBoatItemBase{
         virtual ~GwBoatItemBase(){}
         void invalidate(){
             lastSet=0;
+            version=++changeCounter;
         }
         const char *getDataString(){
             fillString();
@@ -98,9 +109,12 @@ class GwBoatItemBase{
         TOType getToType(){return toType;}
         class GwBoatItemMap : public std::map<String,GwBoatItemBase*>{
             GwBoatData *boatData;
+            int nextId=0;
             public:
             GwBoatItemMap(GwBoatData *bd):boatData(bd){}
             void add(const String &name,GwBoatItemBase *item);
+            //changes whenever an item is added
+            int getSchemaVersion() const {return nextId;}
         };
 };
 template<class T> class GwBoatItem : public GwBoatItemBase{
@@ -235,6 +249,10 @@ class GwBoatData{
     GWBOATDATA(double,XTE,formatXte) // cross track error
     GWBOATDATA(double,WPLat,formatLatitude) // waypoint latitude
     GWBOATDATA(double,WPLon,formatLongitude) // waypoint longitude
+    GWBOATDATA(double,VMG,formatKnots) // velocity made good towards the waypoint
+    GWBOATDATA(double,Set,formatCourse) // direction of the current
+    GWBOATDATA(double,Drift,formatKnots) // speed of the current
+    GWBOATDATA(double,Leeway,formatWind) // leeway angle, positive to starboard
     GWSPECBOATDATA(GwBoatDataSatList,SatInfo,GwSatInfoList::toType,formatFixed0);
     public:
         GwBoatData(GwLog *logger, GwConfigHandler *cfg);
@@ -249,6 +267,18 @@ class GwBoatData{
         GwBoatItemBase *getBase(String name);
         String toJson() const;
         String toString();
+        /**
+         * compact binary (MessagePack) representation
+         * a map with
+         *   "v": current change counter (use as since for the next request)
+         *   "s": schema version (changes when items are added)
+         *   "schema": (only if withSchema) array of [id,name,format,invalidTime(ms)]
+         *   "d": array of [id,value,age(ms),source,valid] for all items changed after since
+         * items becoming invalid due to their timeout are not reported as changes,
+         * clients can derive this from age and invalidTime
+         */
+        void toBinary(std::vector<uint8_t> &out,unsigned long since,bool withSchema) const;
+        int getSchemaVersion() const {return values.getSchemaVersion();}
 };
 
 
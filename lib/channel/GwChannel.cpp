@@ -17,7 +17,15 @@ class GwChannelMessageReceiver : public GwMessageFetcher{
     void setHandler(GwChannel::NMEA0183Handler handler){
         this->handler=handler;
     }
-    virtual bool handleBuffer(GwBuffer *gwbuffer){
+    //budget for one call of handleBuffer
+    int maxMessages=GwChannel::READ_BUDGET_MESSAGES;
+    unsigned long maxTime=GwChannel::READ_BUDGET_US;
+    //statistics
+    unsigned long budgetHits=0;
+    size_t backlog=0;
+    size_t maxBacklog=0;
+    int maxPerCall=0;
+    bool handleMessage(GwBuffer *gwbuffer){
       size_t len=fetchMessageToBuffer(gwbuffer,buffer,bufferSize-4,'\n');
       writePointer=buffer+len;
       if (writePointer == buffer) return false;
@@ -47,6 +55,25 @@ class GwChannelMessageReceiver : public GwMessageFetcher{
       writePointer=buffer;
       return true;
     }
+    /**
+     * handle all complete messages from the buffer
+     * until the budget (number of messages, time) is exhausted
+     */
+    virtual bool handleBuffer(GwBuffer *gwbuffer){
+      unsigned long start=micros();
+      int num=0;
+      while (handleMessage(gwbuffer)){
+        num++;
+        if (num >= maxMessages || (micros()-start) >= maxTime){
+          if (gwbuffer->findChar('\n') >= 0) budgetHits++;
+          break;
+        }
+      }
+      backlog=gwbuffer->usedSpace();
+      if (backlog > maxBacklog) maxBacklog=backlog;
+      if (num > maxPerCall) maxPerCall=num;
+      return num > 0;
+    }
 };
 
 
@@ -71,7 +98,9 @@ void GwChannel::begin(
     bool seaSmartOut,
     bool toN2k,
     bool readActisense,
-    bool writeActisense)
+    bool writeActisense,
+    String pgnFilter,
+    float aisThinRange)
 {
     this->enabled = enabled;
     this->NMEAout = nmeaOut;
@@ -82,6 +111,13 @@ void GwChannel::begin(
     this->writeFilter=writeFilter.isEmpty()?
         NULL:
         new GwNmeaFilter(writeFilter);
+    this->pgnFilter=pgnFilter.isEmpty()?
+        NULL:
+        new GwPgnFilter(pgnFilter);
+    if (aisThinRange > 0){
+        this->aisThinner=new GwAisThinner();
+        aisThinner->setRange(aisThinRange);
+    }
     this->seaSmartOut=seaSmartOut;
     this->toN2k=toN2k;
     this->readActisense=readActisense;
@@ -105,6 +141,10 @@ void GwChannel::begin(
         this->countOut=new GwCounter<String>(String("count")+name+String("out"));
     }
 }
+void GwChannel::setReadBudget(int maxMessages, unsigned long maxUs){
+    receiver->maxMessages=maxMessages > 0?maxMessages:1;
+    receiver->maxTime=maxUs;
+}
 void GwChannel::setImpl(GwChannelInterface *impl){
     this->impl=impl;
 }
@@ -151,6 +191,14 @@ bool GwChannel::canSendOut(const char *buffer, bool isSeasmart){
     if (readActisense) return false;
     if (! isSeasmart && ! NMEAout) return false;
     if (isSeasmart && ! seaSmartOut) return false;
+    if (isSeasmart && pgnFilter){
+        //$PCDIN,01F119,...
+        if (strlen(buffer) < 13) return false;
+        char pgn[7];
+        strncpy(pgn,buffer+7,6);
+        pgn[6]=0;
+        if (! pgnFilter->canPass(strtoul(pgn,NULL,16))) return false;
+    }
     if (writeFilter && ! writeFilter->canPass(buffer)) return false;
     return true;
 }
@@ -164,7 +212,10 @@ bool GwChannel::canReceive(const char *buffer){
 }
 
 int GwChannel::getJsonSize(){
-    int rt=JSON_OBJECT_SIZE(6);
+    int rt=JSON_OBJECT_SIZE(8);
+    if (NMEAin) rt+=JSON_OBJECT_SIZE(5);
+    if (aisThinner) rt+=JSON_OBJECT_SIZE(2);
+    if (impl) rt+=impl->getJsonSize();
     if (countIn) rt+=countIn->getJsonSize();
     if (countOut) rt+=countOut->getJsonSize();
     return rt;
@@ -173,6 +224,20 @@ void GwChannel::toJson(GwJsonDocument &doc){
     JsonObject jo=doc.createNestedObject("ch"+name);
     jo["id"]=sourceId;
     jo["max"]=maxSourceId;
+    if (NMEAin){
+        JsonObject jr=jo.createNestedObject("rx");
+        jr["backlog"]=receiver->backlog;
+        jr["maxBacklog"]=receiver->maxBacklog;
+        jr["maxPerLoop"]=receiver->maxPerCall;
+        jr["budgetHits"]=receiver->budgetHits;
+        jr["overflows"]=receiver->overflows;
+    }
+    if (aisThinner){
+        JsonObject ja=jo.createNestedObject("aisThin");
+        ja["forwarded"]=aisThinner->getForwarded();
+        ja["suppressed"]=aisThinner->getSuppressed();
+    }
+    if (impl) impl->toJson(jo);
     if (countOut) countOut->toJson(doc);
     if (countIn) countIn->toJson(doc);
 }
@@ -183,10 +248,12 @@ String GwChannel::toString(){
     rt+=NMEAout?"out,":"";
     rt+=String("RF:") + (readFilter?readFilter->toString():"[]");
     rt+=String("WF:") + (writeFilter?writeFilter->toString():"[]");
+    rt+=String("PF:") + (pgnFilter?pgnFilter->toString():"[]");
     rt+=String(",")+ (toN2k?"n2k":"");
     rt+=String(",")+ (seaSmartOut?"SM":"");
     rt+=String(",")+(readActisense?"AR":"");
     rt+=String(",")+(writeActisense?"AW":"");
+    rt+=String(",")+(aisThinner?"AT":"");
     return rt;
 }
 void GwChannel::loop(bool handleRead, bool handleWrite){
@@ -200,9 +267,10 @@ void GwChannel::readMessages(GwChannel::NMEA0183Handler handler){
     receiver->setHandler(handler);
     impl->readMessages(receiver);
 }
-void GwChannel::sendToClients(const char *buffer, int sourceId, bool isSeasmart){
+void GwChannel::sendToClients(const char *buffer, int sourceId, bool isSeasmart, const GwAisTargets::ThinInfo *ais){
     if (! impl) return;
     if (canSendOut(buffer,isSeasmart)){
+        if (ais && aisThinner && ! aisThinner->canPass(*ais)) return;
         if(impl->sendToClients(buffer,sourceId)){
             updateCounter(buffer,true);
         }
@@ -218,14 +286,27 @@ void GwChannel::parseActisense(N2kHandler handler){
     }
 }
 
-void GwChannel::sendActisense(const tN2kMsg &msg, int sourceId){
-    if (!enabled || ! impl || ! writeActisense || ! channelStream) return;
+void GwChannel::sendN2k(GwN2kEncodings &encodings, int sourceId, const GwAisTargets::ThinInfo *ais){
+    if (!enabled || ! impl || ! writeActisense) return;
     //currently actisense only for channels with a single source id
     //so we can check it here
     if (maxSourceId < 0 && this->sourceId == sourceId) return;
     if (sourceId >= this->sourceId && sourceId <= maxSourceId) return;
+    const tN2kMsg &msg=encodings.getMessage();
+    if (pgnFilter && ! pgnFilter->canPass(msg.PGN)) return;
+    if (ais && aisThinner && ! aisThinner->canPass(*ais)) return;
+    if (! channelStream){
+        //channels with an own N2K format
+        if (impl->sendN2k(encodings,sourceId) > 0){
+            if(countOut) countOut->add(String(msg.PGN));
+        }
+        return;
+    }
+    size_t len=0;
+    const uint8_t *data=encodings.get(GwN2kEncodings::ACTISENSE,len);
+    if (! data) return;
     if(countOut) countOut->add(String(msg.PGN)); 
-    msg.SendInActisenseFormat(channelStream);
+    channelStream->write(data,len);
 }
 
 bool GwChannel::overlaps(const GwChannel *other) const{
@@ -5,6 +5,8 @@
 #include "GWConfig.h"
 #include "GwCounter.h"
 #include "GwJsonDocument.h"
+#include "GwN2kEncodings.h"
+#include "GwAisTargets.h"
 #include <N2kMsg.h>
 #include <functional>
 
@@ -16,6 +18,8 @@ class GwChannel{
     bool NMEAin=false;
     GwNmeaFilter* readFilter=NULL;
     GwNmeaFilter* writeFilter=NULL;
+    GwPgnFilter* pgnFilter=NULL;
+    GwAisThinner* aisThinner=NULL;
     bool seaSmartOut=false;
     bool toN2k=false;
     bool readActisense=false;
@@ -32,6 +36,9 @@ class GwChannel{
     Stream *channelStream=NULL;
     void updateCounter(const char *msg, bool out);
     public:
+    //default budget for handling received NMEA0183 messages per loop
+    static const int READ_BUDGET_MESSAGES=20;
+    static const unsigned long READ_BUDGET_US=5000;
     GwChannel(
         GwLog *logger,
         String name,
@@ -46,10 +53,13 @@ class GwChannel{
         bool seaSmartOut,
         bool toN2k,
         bool readActisense=false,
-        bool writeActisense=false
+        bool writeActisense=false,
+        String pgnFilter="",
+        float aisThinRange=0
     );
 
     void setImpl(GwChannelInterface *impl);
+    void setReadBudget(int maxMessages, unsigned long maxUs);
     bool overlaps(const GwChannel *) const;
     void enable(bool enabled){
         this->enabled=enabled;
@@ -59,6 +69,12 @@ class GwChannel{
     bool canSendOut(const char *buffer, bool isSeasmart);
     bool canReceive(const char *buffer);
     bool sendSeaSmart(){ return seaSmartOut;}
+    bool sendSeaSmart(unsigned long pgn){
+        return seaSmartOut && canPassPgn(pgn);
+    }
+    bool canPassPgn(unsigned long pgn){
+        return pgnFilter == NULL || pgnFilter->canPass(pgn);
+    }
     bool sendToN2K(){return toN2k;}
     int getJsonSize();
     void toJson(GwJsonDocument &doc);
@@ -67,10 +83,13 @@ class GwChannel{
     void loop(bool handleRead, bool handleWrite);
     typedef std::function<void(const char *buffer, int sourceid)> NMEA0183Handler;
     void readMessages(NMEA0183Handler handler);
-    void sendToClients(const char *buffer, int sourceId, bool isSeasmart=false);
+    /**
+     * @param ais thinning info if the message is an AIS position report
+     */
+    void sendToClients(const char *buffer, int sourceId, bool isSeasmart=false, const GwAisTargets::ThinInfo *ais=nullptr);
     typedef std::function<void(const tN2kMsg &msg, int sourceId)> N2kHandler ;
     void parseActisense(N2kHandler handler);
-    void sendActisense(const tN2kMsg &msg, int sourceId);
+    void sendN2k(GwN2kEncodings &encodings, int sourceId, const GwAisTargets::ThinInfo *ais=nullptr);
     unsigned long countRx();
     unsigned long countTx();
     bool isOwnSource(int source){
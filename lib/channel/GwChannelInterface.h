@@ -1,6 +1,8 @@
 #pragma once
 #include "GwBuffer.h"
 #include "GwChannelModes.h"
+#include "GwJsonDocument.h"
+class GwN2kEncodings;
 class GwChannelInterface{
     public:
         virtual void loop(bool handleRead,bool handleWrite)=0;
@@ -8,4 +10,10 @@ class GwChannelInterface{
         virtual size_t sendToClients(const char *buffer, int sourceId, bool partial=false)=0;
         virtual Stream * getStream(bool partialWrites){ return NULL;}
         virtual int getType(){ return GWSERIAL_TYPE_BI;} //return the numeric type
+        //send a NMEA2000 message in the channels own format
+        //only used for channels without a stream
+        virtual size_t sendN2k(GwN2kEncodings &encodings, int sourceId){ return 0;}
+        //implementation specific status, added to the channel status
+        virtual int getJsonSize(){ return 0;}
+        virtual void toJson(JsonObject &jo){}
 };
\ No newline at end of file
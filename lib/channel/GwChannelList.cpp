@@ -8,6 +8,7 @@
 #include "GwTcpClient.h"
 #include "GwUdpWriter.h"
 #include "GwUdpReader.h"
+#include "GwN2kUdpWriter.h"
 class SerInit{
     public:
         int serial=-1;
@@ -160,13 +161,18 @@ typedef struct {
     const char *receive;
     const char *send;
     const char *direction;
+    const char *enable; //enable flag of the channel, "" if enabled by the directions
     const char *toN2K;
     const char *readF;
     const char *writeF;
     const char *preventLog;
     const char *readAct;
     const char *writeAct;
+    bool n2kOut; //the channel only writes NMEA2000 in its own format
     const char *sendSeasmart;
+    const char *pgnF;
+    const char *aisThin;
+    const char *readBudget;
     const char *name;
     int maxId;
     size_t rxstatus;
@@ -180,13 +186,18 @@ static  ChannelParam channelParameters[]={
         .receive=GwConfigDefinitions::receiveUsb,
         .send=GwConfigDefinitions::sendUsb,
         .direction="",
+        .enable="",
         .toN2K=GwConfigDefinitions::usbToN2k,
         .readF=GwConfigDefinitions::usbReadFilter,
         .writeF=GwConfigDefinitions::usbWriteFilter,
         .preventLog=GwConfigDefinitions::usbActisense,
         .readAct=GwConfigDefinitions::usbActisense,
         .writeAct=GwConfigDefinitions::usbActSend,
+        .n2kOut=false,
         .sendSeasmart="",
+        .pgnF=GwConfigDefinitions::usbPgnFilter,
+        .aisThin=GwConfigDefinitions::usbAisThin,
+        .readBudget=GwConfigDefinitions::usbRdBudget,
         .name="USB",
         .maxId=-1,
         .rxstatus=offsetof(GwApi::Status,GwApi::Status::usbRx),
@@ -198,13 +209,18 @@ static  ChannelParam channelParameters[]={
         .receive=GwConfigDefinitions::receiveSerial,
         .send=GwConfigDefinitions::sendSerial,
         .direction=GwConfigDefinitions::serialDirection,
+        .enable="",
         .toN2K=GwConfigDefinitions::serialToN2k,
         .readF=GwConfigDefinitions::serialReadF,
         .writeF=GwConfigDefinitions::serialWriteF,
         .preventLog="",
         .readAct="",
         .writeAct="",
+        .n2kOut=false,
         .sendSeasmart="",
+        .pgnF="",
+        .aisThin=GwConfigDefinitions::serialAisThin,
+        .readBudget=GwConfigDefinitions::serialRdBudget,
         .name="Serial",
         .maxId=-1,
         .rxstatus=offsetof(GwApi::Status,GwApi::Status::serRx),
@@ -216,13 +232,18 @@ static  ChannelParam channelParameters[]={
         .receive=GwConfigDefinitions::receiveSerial2,
         .send=GwConfigDefinitions::sendSerial2,
         .direction=GwConfigDefinitions::serial2Dir,
+        .enable="",
         .toN2K=GwConfigDefinitions::serial2ToN2k,
         .readF=GwConfigDefinitions::serial2ReadF,
         .writeF=GwConfigDefinitions::serial2WriteF,
         .preventLog="",
         .readAct="",
         .writeAct="",
+        .n2kOut=false,
         .sendSeasmart="",
+        .pgnF="",
+        .aisThin=GwConfigDefinitions::serial2AisThin,
+        .readBudget=GwConfigDefinitions::serial2RdBudget,
         .name="Serial2",
         .maxId=-1,
         .rxstatus=offsetof(GwApi::Status,GwApi::Status::ser2Rx),
@@ -234,13 +255,18 @@ static  ChannelParam channelParameters[]={
         .receive=GwConfigDefinitions::readTCP,
         .send=GwConfigDefinitions::sendTCP,
         .direction="",
+        .enable="",
         .toN2K=GwConfigDefinitions::tcpToN2k,
         .readF=GwConfigDefinitions::tcpReadFilter,
         .writeF=GwConfigDefinitions::tcpWriteFilter,
         .preventLog="",
         .readAct="",
         .writeAct="",
+        .n2kOut=false,
         .sendSeasmart=GwConfigDefinitions::sendSeasmart,
+        .pgnF=GwConfigDefinitions::tcpPgnFilter,
+        .aisThin=GwConfigDefinitions::tcpAisThin,
+        .readBudget=GwConfigDefinitions::tcpRdBudget,
         .name="TCPServer",
         .maxId=MIN_TCP_CHANNEL_ID+10,
         .rxstatus=offsetof(GwApi::Status,GwApi::Status::tcpSerRx),
@@ -252,13 +278,18 @@ static  ChannelParam channelParameters[]={
         .receive=GwConfigDefinitions::readTCL,
         .send=GwConfigDefinitions::sendTCL,
         .direction="",
+        .enable="",
         .toN2K=GwConfigDefinitions::tclToN2k,
         .readF=GwConfigDefinitions::tclReadFilter,
         .writeF=GwConfigDefinitions::tclWriteFilter,
         .preventLog="",
         .readAct="",
         .writeAct="",
+        .n2kOut=false,
         .sendSeasmart=GwConfigDefinitions::tclSeasmart,
+        .pgnF=GwConfigDefinitions::tclPgnFilter,
+        .aisThin=GwConfigDefinitions::tclAisThin,
+        .readBudget=GwConfigDefinitions::tclRdBudget,
         .name="TCPClient",
         .maxId=-1,
         .rxstatus=offsetof(GwApi::Status,GwApi::Status::tcpClRx),
@@ -270,13 +301,18 @@ static  ChannelParam channelParameters[]={
         .receive="",
         .send=GwConfigDefinitions::udpwEnabled,
         .direction="",
+        .enable="",
         .toN2K="",
         .readF="",
         .writeF=GwConfigDefinitions::udpwWriteFilter,
         .preventLog="",
         .readAct="",
         .writeAct="",
+        .n2kOut=false,
         .sendSeasmart=GwConfigDefinitions::udpwSeasmart,
+        .pgnF=GwConfigDefinitions::udpwPgnFilter,
+        .aisThin=GwConfigDefinitions::udpwAisThin,
+        .readBudget="",
         .name="UDPWriter",
         .maxId=-1,
         .rxstatus=0,
@@ -288,17 +324,45 @@ static  ChannelParam channelParameters[]={
         .receive=GwConfigDefinitions::udprEnabled,
         .send="",
         .direction="",
+        .enable="",
         .toN2K=GwConfigDefinitions::udprToN2k,
         .readF=GwConfigDefinitions::udprReadFilter,
         .writeF="",
         .preventLog="",
         .readAct="",
         .writeAct="",
+        .n2kOut=false,
         .sendSeasmart="",
+        .pgnF="",
+        .aisThin="",
+        .readBudget=GwConfigDefinitions::udprRdBudget,
         .name="UDPReader",
         .maxId=-1,
         .rxstatus=offsetof(GwApi::Status,GwApi::Status::udprRx),
         .txstatus=0
+    },
+    {
+        .id=N2KU_CHANNEL_ID,
+        .baud="",
+        .receive="",
+        .send="",
+        .direction="",
+        .enable=GwConfigDefinitions::n2kuEnabled,
+        .toN2K="",
+        .readF="",
+        .writeF="",
+        .preventLog="",
+        .readAct="",
+        .writeAct="",
+        .n2kOut=true,
+        .sendSeasmart="",
+        .pgnF=GwConfigDefinitions::n2kuPgnFilter,
+        .aisThin=GwConfigDefinitions::n2kuAisThin,
+        .readBudget="",
+        .name="N2KUDP",
+        .maxId=-1,
+        .rxstatus=0,
+        .txstatus=0
     }
 
 
@@ -418,10 +482,12 @@ static GwChannel * createChannel(GwLog *logger, GwConfigHandler *config, int id,
     GwChannel *channel = new GwChannel(logger, param->name,param->id,param->maxId);
     bool sendSeaSmart=config->getBool(param->sendSeasmart);
     bool readAct=config->getBool(param->readAct);
-    bool writeAct=config->getBool(param->writeAct);
+    bool writeAct=param->n2kOut || config->getBool(param->writeAct);
+    bool enabled=canRead || canWrite || readAct || writeAct|| sendSeaSmart;
+    if (param->enable[0] != 0) enabled=config->getBool(param->enable);
     channel->setImpl(impl);
     channel->begin(
-        canRead || canWrite || readAct || writeAct|| sendSeaSmart,
+        enabled,
         canWrite,
         canRead,
         config->getString(param->readF),
@@ -429,7 +495,12 @@ static GwChannel * createChannel(GwLog *logger, GwConfigHandler *config, int id,
         sendSeaSmart,
         config->getBool(param->toN2K),
         readAct,
-        writeAct);
+        writeAct,
+        config->getString(param->pgnF),
+        config->getString(param->aisThin).toFloat());
+    channel->setReadBudget(
+        config->getInt(param->readBudget,GwChannel::READ_BUDGET_MESSAGES),
+        GwChannel::READ_BUDGET_US);
     LOG_INFO("created channel %s",channel->toString().c_str());
     return channel;
 }
@@ -486,6 +557,7 @@ void GwChannelList::begin(bool fallbackSerial){
     }
     //TCP server
     sockets=new GwSocketServer(config,logger,MIN_TCP_CHANNEL_ID);
+    sockets->setReadiness(&readiness);
     sockets->begin();
     addChannel(createChannel(logger,config,MIN_TCP_CHANNEL_ID,sockets));
 
@@ -509,28 +581,44 @@ void GwChannelList::begin(bool fallbackSerial){
     bool tclEnabled=config->getBool(config->tclEnabled);
     if (tclEnabled){
         client=new GwTcpClient(logger);
+        client->setReadiness(&readiness);
         client->begin(TCP_CLIENT_CHANNEL_ID,
             config->getString(config->remoteAddress),
             config->getInt(config->remotePort),
-            config->getBool(config->readTCL)
+            config->getBool(config->readTCL),
+            ! config->getBool(config->tclBatch)
         );
         addChannel(createChannel(logger,config,TCP_CLIENT_CHANNEL_ID,client));
     }
 
     //udp writer
     if (config->getBool(GwConfigDefinitions::udpwEnabled)){
-        GwUdpWriter *writer=new GwUdpWriter(config,logger,UDPW_CHANNEL_ID);
-        writer->begin();
-        addChannel(createChannel(logger,config,UDPW_CHANNEL_ID,writer));
+        udpWriter=new GwUdpWriter(config,logger,UDPW_CHANNEL_ID);
+        udpWriter->begin();
+        addChannel(createChannel(logger,config,UDPW_CHANNEL_ID,udpWriter));
     }
     //udp reader
     if (config->getBool(GwConfigDefinitions::udprEnabled)){
-        GwUdpReader *reader=new GwUdpReader(config,logger,UDPR_CHANNEL_ID);
-        reader->begin();
-        addChannel(createChannel(logger,config,UDPR_CHANNEL_ID,reader));
+        udpReader=new GwUdpReader(config,logger,UDPR_CHANNEL_ID);
+        udpReader->setReadiness(&readiness);
+        udpReader->begin();
+        addChannel(createChannel(logger,config,UDPR_CHANNEL_ID,udpReader));
+    }
+    //N2K udp writer
+    if (config->getBool(GwConfigDefinitions::n2kuEnabled)){
+        n2kUdpWriter=new GwN2kUdpWriter(config,logger,N2KU_CHANNEL_ID);
+        n2kUdpWriter->begin();
+        addChannel(createChannel(logger,config,N2KU_CHANNEL_ID,n2kUdpWriter));
     }
     logger->flush();
 }
+void GwChannelList::checkReadiness(){
+    readiness.reset();
+    if (sockets) sockets->addFds(&readiness);
+    if (client) client->addFds(&readiness);
+    if (udpReader) udpReader->addFds(&readiness);
+    readiness.select();
+}
 String GwChannelList::getMode(int id){
     for (auto && c: theChannels){
         if (c->isOwnSource(id)) return c->getMode();
@@ -542,6 +630,10 @@ int GwChannelList::getJsonSize(){
     allChannels([&](GwChannel *c){
         rt+=c->getJsonSize();
     });
+    if (n2kUdpWriter) rt+=JSON_OBJECT_SIZE(4);
+    if (udpWriter) rt+=JSON_OBJECT_SIZE(4);
+    if (udpReader) rt+=JSON_OBJECT_SIZE(5);
+    rt+=readiness.getJsonSize();
     return rt+20;
 }
 void GwChannelList::toJson(GwJsonDocument &doc){
@@ -554,6 +646,26 @@ void GwChannelList::toJson(GwJsonDocument &doc){
         doc["clientCon"]=false;
         doc["clientErr"]="disabled";
     }
+    readiness.toJson(doc);
+    if (udpWriter){
+        doc["udpwSentences"]=udpWriter->getSentences();
+        doc["udpwDatagrams"]=udpWriter->getDatagrams();
+        doc["udpwSentencesPerS"]=udpWriter->getSentenceRate();
+        doc["udpwDatagramsPerS"]=udpWriter->getDatagramRate();
+    }
+    if (udpReader){
+        doc["udprDatagrams"]=udpReader->getDatagrams();
+        doc["udprBufferDrops"]=udpReader->getBufferDrops();
+        doc["udprTruncated"]=udpReader->getTruncated();
+        doc["udprErrors"]=udpReader->getSocketErrors();
+        doc["udpStackDrops"]=GwUdpReader::getStackDrops();
+    }
+    if (n2kUdpWriter){
+        doc["n2kuMessages"]=n2kUdpWriter->getMessages();
+        doc["n2kuDatagrams"]=n2kUdpWriter->getDatagrams();
+        doc["n2kuBytes"]=n2kUdpWriter->getBytes();
+        doc["n2kuErrors"]=n2kUdpWriter->getErrors();
+    }
     allChannels([&](GwChannel *c){
         c->toJson(doc);
     });
@@ -9,6 +9,7 @@
 #include "GwJsonDocument.h"
 #include "GwApi.h"
 #include "GwSerial.h"
+#include "GwSocketReadiness.h"
 #include <HardwareSerial.h>
 
 //NMEA message channels
@@ -20,18 +21,28 @@
 #define MIN_TCP_CHANNEL_ID 5
 #define UDPW_CHANNEL_ID 20
 #define UDPR_CHANNEL_ID 21
+#define N2KU_CHANNEL_ID 22
+//boat data computed from other items (GwDerivedData)
+#define DERIVED_CHANNEL_ID 190
 
 #define MIN_USER_TASK 200
 class GwSocketServer;
 class GwTcpClient;
+class GwN2kUdpWriter;
+class GwUdpWriter;
+class GwUdpReader;
 class GwChannelList{
     private:
         GwLog *logger;
         GwConfigHandler *config;
         typedef std::vector<GwChannel *> ChannelList;
         ChannelList theChannels;
-        GwSocketServer *sockets;
-        GwTcpClient *client;
+        GwSocketServer *sockets=nullptr;
+        GwTcpClient *client=nullptr;
+        GwN2kUdpWriter *n2kUdpWriter=nullptr;
+        GwUdpWriter *udpWriter=nullptr;
+        GwUdpReader *udpReader=nullptr;
+        GwSocketReadiness readiness;
     public:
         void addChannel(GwChannel *);
         GwChannelList(GwLog *logger, GwConfigHandler *config);
@@ -42,6 +53,8 @@ class GwChannelList{
         void preinit();
         //initialize
         void begin(bool fallbackSerial=false);
+        //check which sockets are ready, call before the read phase of the loop
+        void checkReadiness();
         //status
         int getJsonSize();
         void toJson(GwJsonDocument &doc);
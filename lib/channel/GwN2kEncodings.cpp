@@ -0,0 +1,292 @@
+#include "GwN2kEncodings.h"
+#include <Seasmart.h>
+#include <NMEA2000.h>
+#include <vector>
+#include "GwSynchronized.h"
+
+class GwN2kEncodings::Buffer{
+    public:
+        uint8_t *data;
+        size_t size;
+        Buffer(size_t s):size(s){
+            data=new uint8_t[s];
+        }
+        ~Buffer(){
+            delete[] data;
+        }
+};
+
+/**
+ * a stream writing into a fixed buffer
+ * used to capture the actisense encoding of the N2K lib
+ */
+class GwFixedBufferStream : public Stream{
+    uint8_t *buffer;
+    size_t size;
+    size_t fill=0;
+    bool overflow=false;
+    public:
+        GwFixedBufferStream(uint8_t *b,size_t s):buffer(b),size(s){}
+        virtual int available(){return 0;}
+        virtual int read(){return -1;}
+        virtual int peek(){return -1;}
+        virtual void flush(){}
+        virtual size_t write(uint8_t v){
+            if (fill >= size){
+                overflow=true;
+                return 0;
+            }
+            buffer[fill]=v;
+            fill++;
+            return 1;
+        }
+        virtual size_t write(const uint8_t *data, size_t len){
+            if ((fill+len) > size){
+                overflow=true;
+                len=size-fill;
+            }
+            memcpy(buffer+fill,data,len);
+            fill+=len;
+            return len;
+        }
+        size_t getFill(){ return overflow?0:fill;}
+};
+
+static size_t bufferSizes[GwN2kEncodings::NUM_TYPES]={
+    GwN2kEncodings::MAX_SEASMART_SIZE+3,
+    GwN2kEncodings::MAX_ACTISENSE_SIZE,
+    GwN2kEncodings::MAX_YDRAW_SIZE,
+    GwN2kEncodings::MAX_BINARY_SIZE
+};
+static const char * typeNames[GwN2kEncodings::NUM_TYPES]={
+    "seasmart",
+    "actisense",
+    "ydraw",
+    "binary"
+};
+
+class GwN2kEncodingPool{
+    SemaphoreHandle_t lock;
+    std::vector<GwN2kEncodings::Buffer *> freeBuffers[GwN2kEncodings::NUM_TYPES];
+    public:
+        unsigned long allocated[GwN2kEncodings::NUM_TYPES];
+        unsigned long encoded[GwN2kEncodings::NUM_TYPES];
+        unsigned long used[GwN2kEncodings::NUM_TYPES];
+        unsigned long failed[GwN2kEncodings::NUM_TYPES];
+        GwN2kEncodingPool(){
+            lock=xSemaphoreCreateMutex();
+            for (int i=0;i<GwN2kEncodings::NUM_TYPES;i++){
+                allocated[i]=0;
+                encoded[i]=0;
+                used[i]=0;
+                failed[i]=0;
+                freeBuffers[i].reserve(4);
+            }
+        }
+        GwN2kEncodings::Buffer *acquire(GwN2kEncodings::Type type){
+            GWSYNCHRONIZED(lock);
+            if (! freeBuffers[type].empty()){
+                GwN2kEncodings::Buffer *rt=freeBuffers[type].back();
+                freeBuffers[type].pop_back();
+                return rt;
+            }
+            allocated[type]++;
+            return new GwN2kEncodings::Buffer(bufferSizes[type]);
+        }
+        void release(GwN2kEncodings::Type type,GwN2kEncodings::Buffer *buffer){
+            GWSYNCHRONIZED(lock);
+            freeBuffers[type].push_back(buffer);
+        }
+};
+
+static GwN2kEncodingPool pool;
+
+GwN2kEncodings::GwN2kEncodings(const tN2kMsg &m,bool r):msg(m),received(r){
+    for (int i=0;i<NUM_TYPES;i++){
+        buffers[i]=nullptr;
+        tried[i]=false;
+        lengths[i]=0;
+    }
+}
+GwN2kEncodings::~GwN2kEncodings(){
+    for (int i=0;i<NUM_TYPES;i++){
+        if (buffers[i]) pool.release((Type)i,buffers[i]);
+    }
+}
+
+unsigned long GwN2kEncodings::getTimestamp(){
+    if (! hasTimestamp){
+        timestamp=millis();
+        hasTimestamp=true;
+    }
+    return timestamp;
+}
+
+bool GwN2kEncodings::encode(Type type, Buffer *buffer, size_t &len){
+    len=0;
+    switch(type){
+        case SEASMART:
+            len=N2kToSeasmart(msg,getTimestamp(),(char *)buffer->data,MAX_SEASMART_SIZE);
+            if (len == 0) return false;
+            buffer->data[len]=0x0d;
+            len++;
+            buffer->data[len]=0x0a;
+            len++;
+            buffer->data[len]=0;
+            return true;
+        case ACTISENSE:
+            {
+                GwFixedBufferStream stream(buffer->data,buffer->size);
+                msg.SendInActisenseFormat(&stream);
+                //an oversized message is rejected, never sent truncated
+                len=stream.getFill();
+            }
+            return len > 0;
+        case YDRAW:
+            len=toYdRaw(msg,received,getTimestamp(),(char *)buffer->data,buffer->size);
+            return len > 0;
+        case BINARY:
+            len=toBinary(msg,received,getTimestamp(),buffer->data,buffer->size);
+            return len > 0;
+        default:
+            break;
+    }
+    return false;
+}
+
+const uint8_t *GwN2kEncodings::get(Type type, size_t &len){
+    len=0;
+    if (type < 0 || type >= NUM_TYPES) return nullptr;
+    pool.used[type]++;
+    if (tried[type]){
+        len=lengths[type];
+        return buffers[type]?buffers[type]->data:nullptr;
+    }
+    tried[type]=true;
+    Buffer *buffer=pool.acquire(type);
+    size_t encodedLen=0;
+    if (! encode(type,buffer,encodedLen)){
+        pool.failed[type]++;
+        pool.release(type,buffer);
+        return nullptr;
+    }
+    pool.encoded[type]++;
+    buffers[type]=buffer;
+    lengths[type]=encodedLen;
+    len=encodedLen;
+    return buffer->data;
+}
+
+unsigned long GwN2kEncodings::canId(const tN2kMsg &msg){
+    unsigned long id=((unsigned long)(msg.Priority & 0x7)) << 26;
+    unsigned char pf=(unsigned char)(msg.PGN >> 8);
+    if (pf < 240){
+        //PDU1: destination in PS
+        id |= ((msg.PGN & 0x3ff00UL) << 8) | (((unsigned long)msg.Destination) << 8);
+    }
+    else{
+        id |= (msg.PGN & 0x3ffffUL) << 8;
+    }
+    id |= msg.Source;
+    return id;
+}
+
+static inline uint8_t *putUint32(uint8_t *p,uint32_t v){
+    *p++=v & 0xff;
+    *p++=(v >> 8) & 0xff;
+    *p++=(v >> 16) & 0xff;
+    *p++=(v >> 24) & 0xff;
+    return p;
+}
+size_t GwN2kEncodings::toBinary(const tN2kMsg &msg, bool received, unsigned long timestamp, uint8_t *buffer, size_t bufferSize){
+    if (msg.DataLen < 0 || msg.DataLen > 223) return 0;
+    size_t len=BINARY_HEADER_SIZE+msg.DataLen;
+    if (len > bufferSize) return 0;
+    uint32_t id=canId(msg);
+    if (! received) id|=0x80000000UL;
+    uint8_t *p=putUint32(buffer,timestamp);
+    p=putUint32(p,id);
+    *p++=(uint8_t)msg.DataLen;
+    memcpy(p,msg.Data,msg.DataLen);
+    return len;
+}
+
+static const char hexDigits[]="0123456789ABCDEF";
+static char *addYdFrame(char *p,const char *prefix,size_t prefixLen,const uint8_t *data,int len){
+    memcpy(p,prefix,prefixLen);
+    p+=prefixLen;
+    for (int i=0;i<len;i++){
+        *p++=' ';
+        *p++=hexDigits[data[i] >> 4];
+        *p++=hexDigits[data[i] & 0xf];
+    }
+    *p++=0x0d;
+    *p++=0x0a;
+    return p;
+}
+
+/**
+ * same decision as the NMEA2000 library when sending to the bus
+ * priority >= 0x80 forces a single frame
+ */
+static bool isFastPacket(const tN2kMsg &msg){
+    if (msg.DataLen > 8) return true;
+    if (msg.Priority >= 0x80) return false;
+    return tNMEA2000::IsFastPacketSystemMessage(msg.PGN) ||
+        tNMEA2000::IsDefaultFastPacketMessage(msg.PGN) ||
+        tNMEA2000::IsProprietaryFastPacketMessage(msg.PGN);
+}
+
+size_t GwN2kEncodings::toYdRaw(const tN2kMsg &msg, bool received, unsigned long timestamp, char *buffer, size_t bufferSize){
+    static uint8_t sequence=0;
+    if (msg.DataLen < 0 || msg.DataLen > 223) return 0;
+    bool fastPacket=isFastPacket(msg);
+    //first fast packet frame carries 6 bytes, the others 7
+    int numFrames=fastPacket?1 + msg.DataLen / 7:1;
+    //"hh:mm:ss.sss R 1FFFFFFF" + 8*" XX" + CRLF
+    static const size_t MAX_LINE=12+3+8+8*3+2;
+    if ((numFrames*MAX_LINE+1) > bufferSize) return 0;
+    char prefix[30];
+    unsigned long secs=timestamp/1000;
+    int prefixLen=snprintf(prefix,sizeof(prefix),"%02lu:%02lu:%02lu.%03lu %c %08lX",
+        (secs/3600)%24,(secs/60)%60,secs%60,timestamp%1000,
+        received?'R':'T',canId(msg));
+    if (prefixLen <= 0 || prefixLen >= (int)sizeof(prefix)) return 0;
+    char *p=buffer;
+    if (! fastPacket){
+        p=addYdFrame(p,prefix,prefixLen,msg.Data,msg.DataLen);
+    }
+    else{
+        uint8_t frame[8];
+        uint8_t seq=(sequence++ & 0x7) << 5;
+        int pos=0;
+        for (int fn=0;fn<numFrames;fn++){
+            int fp=0;
+            frame[fp++]=seq | fn;
+            if (fn == 0){
+                frame[fp++]=(uint8_t)msg.DataLen;
+            }
+            while (fp < 8){
+                frame[fp++]=(pos < msg.DataLen)?msg.Data[pos]:0xff;
+                pos++;
+            }
+            p=addYdFrame(p,prefix,prefixLen,frame,8);
+        }
+    }
+    *p=0;
+    return p-buffer;
+}
+
+int GwN2kEncodings::getJsonSize(){
+    return JSON_OBJECT_SIZE(NUM_TYPES)+NUM_TYPES*JSON_OBJECT_SIZE(4);
+}
+void GwN2kEncodings::toJson(GwJsonDocument &json){
+    JsonObject jo=json.createNestedObject("n2kEncodings");
+    for (int i=0;i<NUM_TYPES;i++){
+        JsonObject jt=jo.createNestedObject(typeNames[i]);
+        jt["encoded"]=pool.encoded[i];
+        jt["used"]=pool.used[i];
+        jt["failed"]=pool.failed[i];
+        jt["buffers"]=pool.allocated[i];
+    }
+}
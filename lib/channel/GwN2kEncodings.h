@@ -0,0 +1,82 @@
+#ifndef _GWN2KENCODINGS_H
+#define _GWN2KENCODINGS_H
+#include <Arduino.h>
+#include <N2kMsg.h>
+#include "GwJsonDocument.h"
+
+/**
+ * shared encodings of one NMEA2000 message
+ * every encoding is created lazily at most once per message
+ * into a buffer from a pool and handed out to all interested channels
+ * create one instance on the stack per message - the buffers are
+ * returned to the pool in the destructor
+ */
+class GwN2kEncodings{
+    public:
+        typedef enum{
+            SEASMART=0, // $PCDIN... including CR/LF, 0 terminated
+            ACTISENSE=1,// binary actisense
+            YDRAW=2,    // yacht devices RAW, one line per CAN frame, 0 terminated
+            BINARY=3,   // compact binary, see toBinary
+            NUM_TYPES=4
+        } Type;
+        static const size_t MAX_SEASMART_SIZE=500;
+        //DLE STX, 13 header bytes, 223 data bytes, CRC, DLE ETX
+        //all bytes between STX and ETX could be escaped (doubled)
+        static const size_t MAX_ACTISENSE_SIZE=2+2*(13+223+1)+2;
+        //max 32 fast packet frames, 12+1+1+8+1+8*3+2
+        static const size_t MAX_YDRAW_SIZE=32*50;
+        static const size_t BINARY_HEADER_SIZE=9;
+        static const size_t MAX_BINARY_SIZE=BINARY_HEADER_SIZE+223;
+        class Buffer;
+    private:
+        const tN2kMsg &msg;
+        bool received;
+        //taken on first use, actisense does not need it
+        unsigned long timestamp=0;
+        bool hasTimestamp=false;
+        unsigned long getTimestamp();
+        Buffer *buffers[NUM_TYPES];
+        bool tried[NUM_TYPES];
+        size_t lengths[NUM_TYPES];
+        bool encode(Type type,Buffer *buffer,size_t &len);
+    public:
+        /**
+         * @param received true if the message was received from the bus
+         *        (direction for YD RAW)
+         */
+        GwN2kEncodings(const tN2kMsg &msg,bool received=true);
+        ~GwN2kEncodings();
+        const tN2kMsg &getMessage() const{ return msg;}
+        /**
+         * get the encoded message
+         * returns nullptr if the message cannot be encoded
+         */
+        const uint8_t *get(Type type,size_t &len);
+        const char *getString(Type type){
+            size_t len;
+            return (const char *)get(type,len);
+        }
+        /**
+         * encode a message as YD RAW
+         * buffer should have MAX_YDRAW_SIZE
+         * returns the length (without the terminating 0), 0 on error
+         */
+        static size_t toYdRaw(const tN2kMsg &msg,bool received,unsigned long timestamp,char *buffer,size_t bufferSize);
+        /**
+         * encode a message in a compact binary form (complete message, not split into frames)
+         * 4 bytes timestamp (ms, little endian)
+         * 4 bytes 29 bit CAN id (little endian), bit 31 set for messages we send
+         * 1 byte data length
+         * data
+         * returns the length, 0 on error
+         */
+        static size_t toBinary(const tN2kMsg &msg,bool received,unsigned long timestamp,uint8_t *buffer,size_t bufferSize);
+        /**
+         * the 29 bit CAN id for a message
+         */
+        static unsigned long canId(const tN2kMsg &msg);
+        static int getJsonSize();
+        static void toJson(GwJsonDocument &json);
+};
+#endif
@@ -5,6 +5,8 @@
 #include <string.h>
 #include <MD5Builder.h>
 #include <esp_partition.h>
+#include <nvs.h>
+#include <algorithm>
 using CfgInit=std::function<void(GwConfigHandler *)>;
 static std::vector<CfgInit> cfgInits;
 #define CFG_INIT(name,value,mode) \
@@ -41,6 +43,7 @@ void GwConfigHandler::logConfig(int level) const
     logger->flush();
 }
 String GwConfigHandler::toJson() const{
+    if (jsonGeneration == generation && ! cachedJson.isEmpty()) return cachedJson;
     String rt;
     int num=getNumConfig();
     DynamicJsonDocument jdoc(JSON_OBJECT_SIZE(num*2));
@@ -54,22 +57,58 @@ String GwConfigHandler::toJson() const{
     }
     serializeJson(jdoc,rt);
     LOG_DEBUG(GwLog::DEBUG,"configJson: %s",rt.c_str());
+    cachedJson=rt;
+    jsonGeneration=generation;
     return rt;
 }
 
-GwConfigInterface * GwConfigHandler::getConfigItem(const String name, bool dummy) const{
+static uint32_t hashName(const char *name){
+    //FNV-1a
+    uint32_t rt=2166136261UL;
+    while (*name){
+        rt^=(uint8_t)(*name);
+        rt*=16777619UL;
+        name++;
+    }
+    return rt;
+}
+void GwConfigHandler::buildIndex(){
+    nameIndexSize=16;
+    while (nameIndexSize < 2*getNumConfig()) nameIndexSize*=2;
+    nameIndex=new int16_t[nameIndexSize];
+    for (int i=0;i<nameIndexSize;i++) nameIndex[i]=-1;
     for (int i=0;i<getNumConfig();i++){
-        if (configs[i]->getName() == name) return configs[i];
+        if (configs[i] == nullptr) continue;
+        uint32_t idx=hashName(configs[i]->getName().c_str()) & (nameIndexSize-1);
+        while (nameIndex[idx] >= 0){
+            idx=(idx+1) & (nameIndexSize-1);
+        }
+        nameIndex[idx]=i;
+    }
+}
+GwConfigInterface * GwConfigHandler::getConfigItem(const char *name, bool dummy) const{
+    if (name != nullptr){
+        uint32_t idx=hashName(name) & (nameIndexSize-1);
+        while (nameIndex[idx] >= 0){
+            GwConfigInterface *rt=configs[nameIndex[idx]];
+            if (strcmp(rt->name.c_str(),name) == 0) return rt;
+            idx=(idx+1) & (nameIndexSize-1);
+        }
     }
     if (!dummy) return NULL;
     return &dummyConfig;
 }
+GwConfigInterface * GwConfigHandler::getConfigItem(const String name, bool dummy) const{
+    return getConfigItem(name.c_str(),dummy);
+}
 #define PREF_NAME "gwprefs"
 GwConfigHandler::GwConfigHandler(GwLog *logger): GwConfigDefinitions(){
     this->logger=logger;
     saltBase=esp_random();
     configs=new GwConfigInterface*[getNumConfig()];
+    for (int i=0;i<getNumConfig();i++) configs[i]=nullptr;
     populateConfigs(configs);
+    buildIndex();
     for (auto &&init:cfgInits){
         init(this);
     }
@@ -77,8 +116,45 @@ GwConfigHandler::GwConfigHandler(GwLog *logger): GwConfigDefinitions(){
 }
 GwConfigHandler::~GwConfigHandler(){
     delete prefs;
+    delete[] nameIndex;
+}
+/**
+ * load all config values in one pass over the nvs entries
+ * of our namespace - avoids the isKey+getString lookup per item
+ * returns false if the nvs cannot be opened or iterated
+ */
+bool GwConfigHandler::loadConfigBulk(){
+    nvs_handle_t handle;
+    if (nvs_open(PREF_NAME,NVS_READONLY,&handle) != ESP_OK) return false;
+    nvs_iterator_t it=nvs_entry_find(NVS_DEFAULT_PART_NAME,PREF_NAME,NVS_TYPE_STR);
+    int numLoaded=0;
+    size_t bufferSize=0;
+    char *buffer=nullptr;
+    while (it != NULL){
+        nvs_entry_info_t info;
+        nvs_entry_info(it,&info);
+        it=nvs_entry_next(it);
+        GwConfigInterface *item=getConfigItem(info.key);
+        if (item == nullptr) continue;
+        size_t len=0;
+        if (nvs_get_str(handle,info.key,NULL,&len) != ESP_OK) continue;
+        if (len > bufferSize){
+            delete[] buffer;
+            bufferSize=len+32;
+            buffer=new char[bufferSize];
+        }
+        if (nvs_get_str(handle,info.key,buffer,&len) != ESP_OK) continue;
+        item->value=buffer;
+        numLoaded++;
+    }
+    nvs_release_iterator(it);
+    delete[] buffer;
+    nvs_close(handle);
+    LOG_DEBUG(GwLog::DEBUG,"loaded %d config values",numLoaded);
+    return true;
 }
 bool GwConfigHandler::loadConfig(){
+    if (loadConfigBulk()) return true;
     prefs->begin(PREF_NAME,true);
     for (int i=0;i<getNumConfig();i++){
         if (!prefs->isKey(configs[i]->getName().c_str())) {
@@ -108,6 +184,124 @@ bool GwConfigHandler::updateValue(String name, String value){
     }
     return true;
 }
+bool GwConfigCheck::check(const String &value) const{
+    switch (kind){
+    case BOOLEAN:
+        if (list == nullptr){
+            return strcasecmp(value.c_str(),"true") == 0 || strcasecmp(value.c_str(),"false") == 0;
+        }
+        //fallthrough
+    case LIST:
+        if (list == nullptr) return true;
+        for (const char * const *e=list;*e != nullptr;e++){
+            if (value == *e) return true;
+        }
+        return false;
+    case NUMBER:{
+        const char *start=value.c_str();
+        char *end=nullptr;
+        double v=strtod(start,&end);
+        if (end == start) return false;
+        if (hasMin && v < min) return false;
+        if (hasMax && v > max) return false;
+        return true;
+        }
+    }
+    return true;
+}
+void GwConfigHandler::beginUpdate(){
+    staged.clear();
+    stagedUnknown=0;
+    stagedInvalid=0;
+    firstInvalid="";
+}
+bool GwConfigHandler::stageValue(const String &name, const String &value){
+    GwConfigInterface *i=getConfigItem(name.c_str());
+    if (i == NULL){
+        LOG_DEBUG(GwLog::LOG,"unknown config item %s",name.c_str());
+        stagedUnknown++;
+        return false;
+    }
+    if (i->isSecret() && value.isEmpty()){
+        LOG_DEBUG(GwLog::LOG,"skip empty password %s",name.c_str());
+        return false;
+    }
+    if (i->asString() == value){
+        staged.erase(i->getName());
+        return false;
+    }
+    if (! i->isValid(value)){
+        LOG_DEBUG(GwLog::ERROR,"invalid value for config item %s",name.c_str());
+        if (stagedInvalid == 0) firstInvalid=i->getName();
+        stagedInvalid++;
+        return false;
+    }
+    staged[i->getName()]=value;
+    return true;
+}
+GwConfigHandler::UpdateResult GwConfigHandler::commitUpdate(){
+    UpdateResult rt;
+    unsigned long start=micros();
+    rt.staged=staged.size();
+    rt.unknown=stagedUnknown;
+    rt.invalid=stagedInvalid;
+    rt.firstInvalid=firstInvalid;
+    if (stagedInvalid > 0){
+        LOG_DEBUG(GwLog::ERROR,"config update rejected, %d invalid values",stagedInvalid);
+        staged.clear();
+        rt.us=micros()-start;
+        return rt;
+    }
+    if (staged.empty()){
+        rt.ok=true;
+        rt.us=micros()-start;
+        return rt;
+    }
+    //we directly use the nvs API here as Preferences commits on every put
+    nvs_handle_t handle;
+    esp_err_t err=nvs_open(PREF_NAME,NVS_READWRITE,&handle);
+    if (err != ESP_OK){
+        LOG_DEBUG(GwLog::ERROR,"unable to open nvs for config update: %d",(int)err);
+        staged.clear();
+        rt.us=micros()-start;
+        return rt;
+    }
+    rt.ok=true;
+    for (auto it=staged.begin();it != staged.end();it++){
+        err=nvs_set_str(handle,it->first.c_str(),it->second.c_str());
+        if (err != ESP_OK){
+            LOG_DEBUG(GwLog::ERROR,"unable to write config %s: %d",it->first.c_str(),(int)err);
+            rt.ok=false;
+            break;
+        }
+        rt.writes++;
+    }
+    if (rt.ok){
+        err=nvs_commit(handle);
+        if (err != ESP_OK){
+            LOG_DEBUG(GwLog::ERROR,"nvs commit failed: %d",(int)err);
+            rt.ok=false;
+        }
+    }
+    else{
+        //the NVS may already have persisted the values we have written,
+        //so restore the current values for them
+        int restore=rt.writes;
+        for (auto it=staged.begin();it != staged.end() && restore > 0;it++,restore--){
+            GwConfigInterface *i=getConfigItem(it->first.c_str());
+            if (i == NULL) continue;
+            nvs_set_str(handle,it->first.c_str(),i->asCString());
+        }
+        nvs_commit(handle);
+        rt.writes=0;
+    }
+    nvs_close(handle);
+    staged.clear();
+    rt.us=micros()-start;
+    LOG_DEBUG(GwLog::LOG,"config update: staged=%d, writes=%d, unknown=%d, %ldus",
+        rt.staged,rt.writes,rt.unknown,(long)rt.us);
+    return rt;
+}
 bool GwConfigHandler::reset(){
     LOG_DEBUG(GwLog::ERROR,"reset config");
     //try to find the nvs partition
@@ -138,26 +332,38 @@ bool GwConfigHandler::reset(){
     prefs->end();
     return true;
 }
-String GwConfigHandler::getString(const String name, String defaultv) const{
+String GwConfigHandler::getString(const char *name, String defaultv) const{
     GwConfigInterface *i=getConfigItem(name,false);
     if (!i) return defaultv;
     return i->asString();
 }
-const char * GwConfigHandler::getCString(const String name, const char *defaultv) const{
+String GwConfigHandler::getString(const String name, String defaultv) const{
+    return getString(name.c_str(),defaultv);
+}
+const char * GwConfigHandler::getCString(const char *name, const char *defaultv) const{
     GwConfigInterface *i=getConfigItem(name,false);
     if (!i) return defaultv;
     return i->asCString();
 }
-bool GwConfigHandler::getBool(const String name, bool defaultv) const{
+const char * GwConfigHandler::getCString(const String name, const char *defaultv) const{
+    return getCString(name.c_str(),defaultv);
+}
+bool GwConfigHandler::getBool(const char *name, bool defaultv) const{
     GwConfigInterface *i=getConfigItem(name,false);
     if (!i) return defaultv;
     return i->asBoolean();
 }
-int GwConfigHandler::getInt(const String name,int defaultv) const{
+bool GwConfigHandler::getBool(const String name, bool defaultv) const{
+    return getBool(name.c_str(),defaultv);
+}
+int GwConfigHandler::getInt(const char *name,int defaultv) const{
     GwConfigInterface *i=getConfigItem(name,false);
     if (!i) return defaultv;
     return i->asInt();
 }
+int GwConfigHandler::getInt(const String name,int defaultv) const{
+    return getInt(name.c_str(),defaultv);
+}
 void GwConfigHandler::stopChanges(){
     allowChanges=false;
 }
@@ -172,6 +378,7 @@ bool GwConfigHandler::setValue(String name, String value, GwConfigInterface::Con
     if (!i) return false;
     i->value=value;
     i->type=type;
+    generation++;
     return true;
 }
 
@@ -303,4 +510,40 @@ String GwNmeaFilter::toString(){
         rt+=","+*it;
     }
     return rt;
+}
+
+GwPgnFilter::GwPgnFilter(const String &config){
+    int colon=config.indexOf(':');
+    String list=config;
+    if (colon >= 0){
+        blacklist=config.substring(0,colon).toInt() != 0;
+        list=config.substring(colon+1);
+    }
+    int found=0;
+    int last=0;
+    while (last < list.length()){
+        found=list.indexOf(',',last);
+        if (found < 0) found=list.length();
+        String tok=list.substring(last,found);
+        tok.trim();
+        if (! tok.isEmpty()){
+            pgns.push_back(tok.toInt());
+        }
+        last=found+1;
+    }
+    //an empty whitelist would block everything
+    if (pgns.empty()) blacklist=true;
+    std::sort(pgns.begin(),pgns.end());
+}
+bool GwPgnFilter::canPass(unsigned long pgn) const{
+    bool found=std::binary_search(pgns.begin(),pgns.end(),pgn);
+    return found != blacklist;
+}
+String GwPgnFilter::toString() const{
+    String rt("PGNFilter: ");
+    rt+="bl:"+String(blacklist);
+    for (auto it=pgns.begin();it != pgns.end();it++){
+        rt+=","+String(*it);
+    }
+    return rt;
 }
\ No newline at end of file
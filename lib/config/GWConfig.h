@@ -15,20 +15,79 @@ class GwConfigHandler: public GwConfigDefinitions{
         typedef std::map<String,String> StringMap;
         boolean allowChanges=true;
         GwConfigInterface **configs;
+        //hash index: config index or -1, size is a power of 2
+        int16_t *nameIndex=nullptr;
+        int nameIndexSize=0;
+        void buildIndex();
+        bool loadConfigBulk();
+        StringMap staged;
+        int stagedUnknown=0;
+        int stagedInvalid=0;
+        String firstInvalid;
+        //incremented on every change of a value, used to cache the json
+        unsigned long generation=0;
+        mutable unsigned long jsonGeneration=0;
+        mutable String cachedJson;
     public:
         public:
         GwConfigHandler(GwLog *logger);
         bool loadConfig();
         void stopChanges();
         bool updateValue(String name, String value);
+        /**
+         * transactional update of multiple values
+         * beginUpdate, stageValue for each value, commitUpdate
+         * all changed values are written in one NVS session with one commit
+         * values are checked when staged, if any value is invalid
+         * or a write fails nothing is committed
+         */
+        class UpdateResult{
+            public:
+            bool ok=false;
+            int staged=0;
+            int unknown=0;
+            int invalid=0;
+            //name of the first invalid item
+            String firstInvalid;
+            int writes=0;
+            unsigned long us=0;
+        };
+        void beginUpdate();
+        bool stageValue(const String &name, const String &value);
+        UpdateResult commitUpdate();
         bool reset();
         void logConfig(int level) const;
         String toJson() const;
         String getString(const String name,const String defaultv="") const;
+        String getString(const char *name,const String defaultv="") const;
         bool getBool(const String name,bool defaultv=false) const ;
+        bool getBool(const char *name,bool defaultv=false) const ;
         int getInt(const String name,int defaultv=0) const;
+        int getInt(const char *name,int defaultv=0) const;
         const char * getCString(const String name, const char *defaultv="") const;
+        const char * getCString(const char *name, const char *defaultv="") const;
         GwConfigInterface * getConfigItem(const String name, bool dummy=false) const;
+        GwConfigInterface * getConfigItem(const char *name, bool dummy=false) const;
+        /**
+         * direct access with the generated handles from GwConfigHandles
+         * e.g. config->get(GwConfigHandles::sendN2k)
+         */
+        template<typename T>
+        GwConfigInterface * getConfigItem(const GwConfigHandle<T> &h) const{
+            return configs[h.index];
+        }
+        bool get(const GwConfigHandle<bool> &h) const{
+            return configs[h.index]->asBoolean();
+        }
+        int get(const GwConfigHandle<int> &h) const{
+            return configs[h.index]->asInt();
+        }
+        float get(const GwConfigHandle<float> &h) const{
+            return configs[h.index]->asFloat();
+        }
+        String get(const GwConfigHandle<String> &h) const{
+            return configs[h.index]->asString();
+        }
         bool checkPass(String hash);
         std::vector<String> getSpecial() const;
         int numSpecial() const;
@@ -41,6 +100,7 @@ class GwConfigHandler: public GwConfigDefinitions{
         bool setValue(String name, String value, GwConfigInterface::ConfigType type);
         static void toHex(unsigned long v,char *buffer,size_t bsize);
         unsigned long getSaltBase(){return saltBase;}
+        unsigned long getGeneration() const {return generation;}
         ~GwConfigHandler();
         bool userChangesAllowed(){return allowChanges;}
         template <typename T>
@@ -3,6 +3,32 @@
 #include "WString.h"
 #include <vector>
 class GwConfigHandler;
+/**
+ * value check for a config item
+ * generated from type, check (checkMinMax, checkPort) and list
+ * of the config definition, same rules as in the web UI
+ */
+class GwConfigCheck{
+    public:
+        typedef enum{
+            BOOLEAN=1,
+            NUMBER=2,
+            LIST=3
+        } Kind;
+    private:
+        Kind kind;
+        //nullptr terminated
+        const char * const *list;
+        bool hasMin;
+        double min;
+        bool hasMax;
+        double max;
+    public:
+        constexpr GwConfigCheck(Kind kind,const char * const *list=nullptr,
+            bool hasMin=false,double min=0,bool hasMax=false,double max=0):
+            kind(kind),list(list),hasMin(hasMin),min(min),hasMax(hasMax),max(max){}
+        bool check(const String &value) const;
+};
 class GwConfigInterface{
     public:
         typedef enum {
@@ -16,13 +42,19 @@ class GwConfigInterface{
         String value;
         bool secret=false;
         ConfigType type=NORMAL;
+        const GwConfigCheck *check=nullptr;
     public:
-        GwConfigInterface(const String &name, const char * initialValue, bool secret=false,ConfigType type=NORMAL){
+        GwConfigInterface(const String &name, const char * initialValue, bool secret=false,ConfigType type=NORMAL,
+            const GwConfigCheck *check=nullptr){
             this->name=name;
             this->initialValue=initialValue;
             this->value=initialValue;
             this->secret=secret;
             this->type=type;
+            this->check=check;
+        }
+        bool isValid(const String &v) const{
+            return check == nullptr || check->check(v);
         }
         virtual String asString() const{
             return value;
@@ -57,6 +89,18 @@ class GwConfigInterface{
         friend class GwConfigHandler;
 };
 
+/**
+ * typed handle for a config item
+ * generated for all items into GwConfigHandles (GwConfigDefinitions.h)
+ * allows direct access without looking up the name
+ */
+template<typename T>
+class GwConfigHandle{
+    public:
+        const int index;
+        constexpr explicit GwConfigHandle(int i):index(i){}
+};
+
 class GwNmeaFilter{
     private:
         String config;
@@ -75,6 +119,22 @@ class GwNmeaFilter{
         String toString();    
 };
 
+/**
+ * filter for NMEA2000 PGNs
+ * "1:126992,129025" 0: whitelist, 1: blacklist, list of PGNs
+ * the list is parsed once into a sorted array
+ * an empty list means no filter - also for a whitelist
+ */
+class GwPgnFilter{
+    private:
+        bool blacklist=true;
+        std::vector<unsigned long> pgns;
+    public:
+        GwPgnFilter(const String &config);
+        bool canPass(unsigned long pgn) const;
+        String toString() const;
+};
+
 #define __XSTR(x) __STR(x)
 #define __STR(x) #x
 #define __EXPAND(x,sf) x ## sf
@@ -0,0 +1,248 @@
+#include "GwDerivedData.h"
+#include <N2kMessages.h>
+#include <NMEA0183Messages.h>
+#include "GwJsonDocument.h"
+
+static double normalize(double angle){
+    while (angle < 0) angle+=2*M_PI;
+    while (angle >= 2*M_PI) angle-=2*M_PI;
+    return angle;
+}
+
+bool GwDerivedData::Output::changed(std::initializer_list<GwBoatItemBase*> inputs){
+    unsigned long max=0;
+    for (auto it=inputs.begin();it != inputs.end();it++){
+        if (*it && (*it)->getVersion() > max) max=(*it)->getVersion();
+    }
+    if (max == version) return false;
+    version=max;
+    return true;
+}
+
+GwDerivedData::GwDerivedData(GwLog *logger,GwBoatData *boatData,int sourceId,
+    N2kSender n2kSender,NMEA0183Sender nmea0183Sender):
+    logger(logger),boatData(boatData),sourceId(sourceId),
+    n2kSender(n2kSender),nmea0183Sender(nmea0183Sender){
+    strcpy(talkerId,"GP");
+}
+
+void GwDerivedData::begin(GwConfigHandler *config){
+    calcTrueWind=config->getBool(config->calcTrueWind,true);
+    heelName=config->getString(config->leewayHeel);
+    heelName.trim();
+    leewayFactor=config->getString(config->leewayFactor,"10").toFloat();
+    sendN2k=config->getBool(config->derivedN2k,false);
+    send0183=config->getBool(config->derived0183,false);
+    strncpy(talkerId,config->getCString(config->talkerId,"GP"),2);
+    talkerId[2]=0;
+    LOG_DEBUG(GwLog::LOG,"derived data: trueWind=%d, heel=%s, leewayFactor=%.1f, n2k=%d, 0183=%d",
+        (int)calcTrueWind,heelName.c_str(),leewayFactor,(int)sendN2k,(int)send0183);
+}
+
+bool GwDerivedData::getValue(GwBoatItem<double> *item,unsigned long now,double &value){
+    if (! item->isValid(now)) return false;
+    value=item->getData();
+    return true;
+}
+
+bool GwDerivedData::getHeading(unsigned long now,double &heading){
+    if (getValue(boatData->HDT,now,heading)) return true;
+    double hdm,var;
+    if (getValue(boatData->HDM,now,hdm) && getValue(boatData->VAR,now,var)){
+        heading=normalize(hdm+var);
+        return true;
+    }
+    return false;
+}
+
+bool GwDerivedData::isExternal(GwBoatItemBase *item,unsigned long now){
+    return item->isValid(now) && item->getLastSource() != sourceId;
+}
+
+void GwDerivedData::sendN2kMsg(const tN2kMsg &msg){
+    if (sendN2k && n2kSender) n2kSender(msg,sourceId);
+}
+void GwDerivedData::send0183Msg(const tNMEA0183Msg &msg){
+    if (send0183 && nmea0183Sender) nmea0183Sender(msg,sourceId);
+}
+
+/**
+ * leeway = factor * heel(deg) / STW(kn)^2 (deg)
+ * positive heel (starboard down) means the wind is from port
+ * and the boat is pushed to starboard
+ */
+void GwDerivedData::computeLeeway(unsigned long now){
+    if (heelName.isEmpty() || leewayFactor <= 0) return;
+    if (! heel){
+        //XDR items only exist after the first value was received
+        heel=boatData->getBase(heelName);
+        if (! heel) return;
+    }
+    if (! leeway.changed({heel,boatData->STW})) return;
+    double stw;
+    if (! heel->isValid(now) || ! getValue(boatData->STW,now,stw)) return;
+    if (stw < MIN_LEEWAY_STW) return;
+    double stwKn=formatKnots(stw);
+    double value=leewayFactor*heel->getDoubleValue()/(stwKn*stwKn);
+    if (value > MAX_LEEWAY) value=MAX_LEEWAY;
+    if (value < -MAX_LEEWAY) value=-MAX_LEEWAY;
+    leeway.computed++;
+    if (! boatData->Leeway->update(value,sourceId)) return;
+    tN2kMsg n2kMsg;
+    SetN2kPGN128000(n2kMsg,sid,value);
+    sendN2kMsg(n2kMsg);
+}
+
+/**
+ * true wind relative to the water if we have STW,
+ * otherwise relative to the ground using SOG/COG
+ */
+void GwDerivedData::computeTrueWind(unsigned long now){
+    if (! calcTrueWind) return;
+    if (isExternal(boatData->TWS,now) || isExternal(boatData->TWA,now)) return;
+    if (! trueWind.changed({boatData->AWA,boatData->AWS,boatData->STW,boatData->SOG,
+        boatData->COG,boatData->HDT,boatData->HDM,boatData->VAR,boatData->Leeway})) return;
+    double awa,aws;
+    if (! getValue(boatData->AWA,now,awa) || ! getValue(boatData->AWS,now,aws)) return;
+    double heading=0;
+    bool hasHeading=getHeading(now,heading);
+    double speed;
+    //direction of the boat movement relative to the bow
+    double angle=0;
+    tN2kWindReference reference=N2kWind_True_water;
+    if (getValue(boatData->STW,now,speed)){
+        getValue(boatData->Leeway,now,angle);
+    }
+    else if (getValue(boatData->SOG,now,speed)){
+        reference=N2kWind_True_boat;
+        double cog;
+        if (hasHeading && getValue(boatData->COG,now,cog)) angle=cog-heading;
+    }
+    else{
+        return;
+    }
+    double x=aws*cos(awa)-speed*cos(angle);
+    double y=aws*sin(awa)-speed*sin(angle);
+    double tws=sqrt(x*x+y*y);
+    double twa=normalize(atan2(y,x));
+    trueWind.computed++;
+    if (! boatData->TWA->update(twa,sourceId)) return;
+    boatData->TWS->update(tws,sourceId);
+    boatData->MaxTws->updateMax(tws,sourceId);
+    tN2kMsg n2kMsg;
+    SetN2kWindSpeed(n2kMsg,sid,tws,twa,reference);
+    sendN2kMsg(n2kMsg);
+    tNMEA0183Msg nmeaMsg;
+    if (NMEA0183SetMWV(nmeaMsg,formatCourse(twa),NMEA0183Wind_True,tws,talkerId)){
+        send0183Msg(nmeaMsg);
+    }
+    if (! hasHeading) return;
+    double twd=normalize(twa+heading);
+    boatData->TWD->update(twd,sourceId);
+    tN2kMsg twdMsg;
+    SetN2kWindSpeed(twdMsg,sid,tws,twd,N2kWind_True_North);
+    sendN2kMsg(twdMsg);
+    if (! nmeaMsg.Init("MWD",talkerId)) return;
+    if (! nmeaMsg.AddDoubleField(formatCourse(twd))) return;
+    if (! nmeaMsg.AddStrField("T")) return;
+    double var;
+    if (getValue(boatData->VAR,now,var)){
+        if (! nmeaMsg.AddDoubleField(formatCourse(twd-var))) return;
+    }
+    else{
+        if (! nmeaMsg.AddEmptyField()) return;
+    }
+    if (! nmeaMsg.AddStrField("M")) return;
+    if (! nmeaMsg.AddDoubleField(formatKnots(tws))) return;
+    if (! nmeaMsg.AddStrField("N")) return;
+    if (! nmeaMsg.AddDoubleField(tws)) return;
+    if (! nmeaMsg.AddStrField("M")) return;
+    send0183Msg(nmeaMsg);
+}
+
+/**
+ * current = movement over ground - movement through water
+ * the water track is the heading corrected by the leeway (if known)
+ */
+void GwDerivedData::computeCurrent(unsigned long now){
+    if (! current.changed({boatData->SOG,boatData->COG,boatData->STW,
+        boatData->HDT,boatData->HDM,boatData->VAR,boatData->Leeway})) return;
+    double sog,cog,stw,heading;
+    if (! getValue(boatData->SOG,now,sog) || ! getValue(boatData->COG,now,cog) ||
+        ! getValue(boatData->STW,now,stw) || ! getHeading(now,heading)) return;
+    double lw=0;
+    getValue(boatData->Leeway,now,lw);
+    double ctw=heading+lw;
+    double north=sog*cos(cog)-stw*cos(ctw);
+    double east=sog*sin(cog)-stw*sin(ctw);
+    double drift=sqrt(north*north+east*east);
+    double set=normalize(atan2(east,north));
+    current.computed++;
+    if (! boatData->Set->update(set,sourceId)) return;
+    boatData->Drift->update(drift,sourceId);
+    tN2kMsg n2kMsg;
+    SetN2kPGN130577(n2kMsg,N2kDM_Estimated,N2khr_true,sid,cog,sog,heading,stw,set,drift);
+    sendN2kMsg(n2kMsg);
+    tNMEA0183Msg nmeaMsg;
+    if (! nmeaMsg.Init("VDR",talkerId)) return;
+    if (! nmeaMsg.AddDoubleField(formatCourse(set))) return;
+    if (! nmeaMsg.AddStrField("T")) return;
+    double var;
+    if (getValue(boatData->VAR,now,var)){
+        if (! nmeaMsg.AddDoubleField(formatCourse(set-var))) return;
+    }
+    else{
+        if (! nmeaMsg.AddEmptyField()) return;
+    }
+    if (! nmeaMsg.AddStrField("M")) return;
+    if (! nmeaMsg.AddDoubleField(formatKnots(drift))) return;
+    if (! nmeaMsg.AddStrField("N")) return;
+    send0183Msg(nmeaMsg);
+}
+
+/**
+ * component of the movement over ground towards the waypoint
+ * there is no separate PGN for this (it is part of 129284 that is owned
+ * by the navigation source), so we only send the WCV sentence
+ */
+void GwDerivedData::computeVmg(unsigned long now){
+    if (! vmg.changed({boatData->SOG,boatData->COG,boatData->BTW})) return;
+    double sog,cog,btw;
+    if (! getValue(boatData->SOG,now,sog) || ! getValue(boatData->COG,now,cog) ||
+        ! getValue(boatData->BTW,now,btw)) return;
+    double value=sog*cos(cog-btw);
+    vmg.computed++;
+    if (! boatData->VMG->update(value,sourceId)) return;
+    tNMEA0183Msg nmeaMsg;
+    if (! nmeaMsg.Init("WCV",talkerId)) return;
+    if (! nmeaMsg.AddDoubleField(formatKnots(value))) return;
+    if (! nmeaMsg.AddStrField("N")) return;
+    if (! nmeaMsg.AddEmptyField()) return;
+    send0183Msg(nmeaMsg);
+}
+
+void GwDerivedData::update(){
+    unsigned long now=millis();
+    sid++;
+    if (sid > 252) sid=0;
+    //leeway first, true wind and current use it
+    computeLeeway(now);
+    computeTrueWind(now);
+    computeCurrent(now);
+    computeVmg(now);
+}
+
+void GwDerivedData::toJson(GwJsonDocument &json){
+    //source definition for the data display
+    JsonObject ch=json.createNestedObject("chDerived");
+    ch["id"]=sourceId;
+    ch["max"]=sourceId;
+    JsonObject jo=json.createNestedObject("derived");
+    jo["trueWind"]=trueWind.computed;
+    jo["leeway"]=leeway.computed;
+    jo["current"]=current.computed;
+    jo["vmg"]=vmg.computed;
+}
+int GwDerivedData::getJsonSize(){
+    return 2*JSON_OBJECT_SIZE(1)+JSON_OBJECT_SIZE(2)+JSON_OBJECT_SIZE(4);
+}
@@ -0,0 +1,83 @@
+#ifndef _GWDERIVEDDATA_H
+#define _GWDERIVEDDATA_H
+#include <Arduino.h>
+#include <functional>
+#include <initializer_list>
+#include <N2kMsg.h>
+#include <NMEA0183Msg.h>
+#include "GwBoatData.h"
+#include "GWConfig.h"
+#include "GwLog.h"
+
+class GwJsonDocument;
+/**
+ * own ship data derived from other boat data items
+ *   true wind from apparent wind, boat speed and heading
+ *     (only if no other source provides true wind)
+ *   leeway estimated from the heel angle (optional)
+ *   set & drift of the current from COG/SOG vs. heading/STW
+ *   VMG towards the active waypoint
+ * an output is only recomputed if one of its inputs has changed,
+ * the results are written back to the boat data with our own source id
+ * (so values from real sources always win) and can be sent out as NMEA2000 and NMEA0183
+ * must be called from the main task (like all boat data updates)
+ */
+class GwDerivedData{
+    public:
+        typedef std::function<void(const tN2kMsg &msg,int sourceId)> N2kSender;
+        typedef std::function<void(const tNMEA0183Msg &msg,int sourceId)> NMEA0183Sender;
+        //leeway is only estimated above this STW (m/s, 1kn)
+        static constexpr double MIN_LEEWAY_STW=0.514;
+        //limit for the leeway estimation (rad)
+        static constexpr double MAX_LEEWAY=45*M_PI/180;
+    private:
+        class Output{
+            public:
+            //max version of the inputs at the last computation
+            unsigned long version=0;
+            unsigned long computed=0;
+            /**
+             * item versions come from one global counter
+             * so the maximum changes whenever any of the inputs changes
+             */
+            bool changed(std::initializer_list<GwBoatItemBase*> inputs);
+        };
+        GwLog *logger;
+        GwBoatData *boatData;
+        int sourceId;
+        N2kSender n2kSender;
+        NMEA0183Sender nmea0183Sender;
+        bool calcTrueWind=true;
+        bool sendN2k=false;
+        bool send0183=false;
+        String heelName;
+        GwBoatItemBase *heel=nullptr;
+        double leewayFactor=10;
+        char talkerId[3];
+        unsigned char sid=0;
+        Output trueWind;
+        Output leeway;
+        Output current;
+        Output vmg;
+        bool getValue(GwBoatItem<double> *item,unsigned long now,double &value);
+        bool getHeading(unsigned long now,double &heading);
+        bool isExternal(GwBoatItemBase *item,unsigned long now);
+        void computeLeeway(unsigned long now);
+        void computeTrueWind(unsigned long now);
+        void computeCurrent(unsigned long now);
+        void computeVmg(unsigned long now);
+        void sendN2kMsg(const tN2kMsg &msg);
+        void send0183Msg(const tNMEA0183Msg &msg);
+    public:
+        GwDerivedData(GwLog *logger,GwBoatData *boatData,int sourceId,
+            N2kSender n2kSender,NMEA0183Sender nmea0183Sender);
+        void begin(GwConfigHandler *config);
+        /**
+         * recompute all outputs with changed inputs
+         */
+        void update();
+        int getSourceId() const{ return sourceId;}
+        void toJson(GwJsonDocument &json);
+        static int getJsonSize();
+};
+#endif
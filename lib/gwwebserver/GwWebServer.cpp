@@ -9,26 +9,49 @@ class EmbeddedFile {
     const uint8_t *start;
     int len;
     String contentType;
-    EmbeddedFile(String name,String contentType, const uint8_t *start,int len){
+    String etag;
+    EmbeddedFile(String name,String contentType, const uint8_t *start,int len,const char *md5){
       this->start=start;
       this->len=len;
       this->contentType=contentType;
+      this->etag=String("\"")+md5+"\"";
       embeddedFiles[name]=this;
     }
 } ;
-#define EMBED_GZ_FILE(fileName, binName, contentType) \
+#define EMBED_GZ_FILE(fileName, binName, contentType, md5) \
   extern const uint8_t  binName##_File[] asm("_binary_" #binName "_start"); \
   extern const uint8_t  binName##_FileLen[] asm("_binary_" #binName "_size"); \
-  const EmbeddedFile binName##_Config(fileName,contentType,(const uint8_t*)binName##_File,(int)binName##_FileLen);
+  const EmbeddedFile binName##_Config(fileName,contentType,(const uint8_t*)binName##_File,(int)binName##_FileLen,md5);
 
 #include "GwEmbeddedFiles.h"
 
+bool GwWebServer::sendNotModified(AsyncWebServerRequest *request, const String &etag){
+    if (etag.isEmpty()) return false;
+    if (! request->hasHeader(F("If-None-Match"))) return false;
+    if (request->getHeader(F("If-None-Match"))->value() != etag) return false;
+    AsyncWebServerResponse *response=request->beginResponse(304);
+    response->addHeader(F("ETag"),etag);
+    request->send(response);
+    return true;
+}
+
 void sendEmbeddedFile(String name,String contentType,AsyncWebServerRequest *request){
     std::map<String,EmbeddedFile*>::iterator it=embeddedFiles.find(name);
     if (it != embeddedFiles.end()){
       EmbeddedFile* found=it->second;
+      if (GwWebServer::sendNotModified(request,found->etag)) return;
       AsyncWebServerResponse *response=request->beginResponse_P(200,contentType,found->start,found->len);
       response->addHeader(F("Content-Encoding"), F("gzip"));
+      response->addHeader(F("ETag"),found->etag);
+      //the urls are not content addressed - so only requests carrying the
+      //md5 (?v=<md5>) can be cached forever, all others must revalidate
+      String version=request->arg("v");
+      if (! version.isEmpty() && found->etag.indexOf(version) == 1){
+        response->addHeader(F("Cache-Control"),F("public, max-age=31536000, immutable"));
+      }
+      else{
+        response->addHeader(F("Cache-Control"),F("no-cache"));
+      }
       request->send(response);
     }
     else{
@@ -65,7 +88,7 @@ GwWebServer::~GwWebServer(){
     server->end();
     delete server;
 }
-void GwWebServer::handleAsyncWebRequest(AsyncWebServerRequest *request, GwRequestMessage *msg)
+void GwWebServer::handleAsyncWebRequest(AsyncWebServerRequest *request, GwRequestMessage *msg, const String &etag)
 {
   GwRequestQueue::MessageSendStatus st=queue->sendAndWait(msg,msg->getTimeout());      
   if (st == GwRequestQueue::MSG_ERR)
@@ -76,7 +99,22 @@ void GwWebServer::handleAsyncWebRequest(AsyncWebServerRequest *request, GwReques
   }
   if (st == GwRequestQueue::MSG_OK)
   {
-    request->send(200, msg->getContentType(), msg->getResult());
+    AsyncWebServerResponse *response=nullptr;
+    if (msg->isBinary()){
+      //copy the data - msg will be gone when the response is sent
+      const std::vector<uint8_t> &data=msg->getBinary();
+      AsyncResponseStream *stream=request->beginResponseStream(msg->getContentType(),data.size()+1);
+      stream->write(data.data(),data.size());
+      response=stream;
+    }
+    else{
+      response=request->beginResponse(200, msg->getContentType(), msg->getResult());
+    }
+    if (! etag.isEmpty()){
+      response->addHeader(F("ETag"),etag);
+      response->addHeader(F("Cache-Control"),F("no-cache"));
+    }
+    request->send(response);
     msg->unref();
     return;
   }
@@ -97,6 +135,10 @@ void GwWebServer::handleAsyncWebRequest(AsyncWebServerRequest *request, GwReques
           return RESPONSE_TRY_AGAIN;
       },
       NULL);
+  if (! etag.isEmpty()){
+    r->addHeader(F("ETag"),etag);
+    r->addHeader(F("Cache-Control"),F("no-cache"));
+  }
   request->onDisconnect([this,msg](void)
                         {
                           LOG_DEBUG(GwLog::DEBUG + 1, "onDisconnect");
@@ -104,15 +146,20 @@ void GwWebServer::handleAsyncWebRequest(AsyncWebServerRequest *request, GwReques
                         });
   request->send(r);
 }
-bool GwWebServer::registerMainHandler(const char *url,RequestCreator creator){
-    server->on(url,HTTP_GET, [this,creator,url](AsyncWebServerRequest *request){
+bool GwWebServer::registerMainHandler(const char *url,RequestCreator creator,EtagFunction etag){
+    server->on(url,HTTP_GET, [this,creator,url,etag](AsyncWebServerRequest *request){
+        String currentEtag;
+        if (etag){
+            currentEtag=(*etag)();
+            if (sendNotModified(request,currentEtag)) return;
+        }
         GwRequestMessage *msg=(*creator)(request);
         if (!msg){
             LOG_DEBUG(GwLog::DEBUG,"creator returns NULL for %s",url);
             request->send(404, "text/plain", "Not found");
             return;
         }
-        handleAsyncWebRequest(request,msg);
+        handleAsyncWebRequest(request,msg,currentEtag);
     });
     return true;
 }
@@ -12,14 +12,25 @@ class GwWebServer{
         GwLog *logger;
     public:
         typedef GwRequestMessage *(RequestCreator)(AsyncWebServerRequest *request);
+        //returns the current ETag of a response, must be callable from the async web task
+        typedef String (EtagFunction)();
         using HandlerFunction=GwApi::HandlerFunction;
         GwWebServer(GwLog *logger, GwRequestQueue *queue,int port);
         ~GwWebServer();
         void begin();
-        bool registerMainHandler(const char *url,RequestCreator creator);
+        /**
+         * if an etag function is given, requests with a matching If-None-Match
+         * get a 304 without passing the main loop
+         */
+        bool registerMainHandler(const char *url,RequestCreator creator,EtagFunction etag=nullptr);
         bool registerHandler(const char * url,HandlerFunction handler);
         bool registerPostHandler(const char *url, ArRequestHandlerFunction requestHandler, ArBodyHandlerFunction bodyHandler);
-        void handleAsyncWebRequest(AsyncWebServerRequest *request, GwRequestMessage *msg);
+        void handleAsyncWebRequest(AsyncWebServerRequest *request, GwRequestMessage *msg, const String &etag=String());
+        /**
+         * send a 304 if the request has a matching If-None-Match
+         * returns true if the request has been handled
+         */
+        static bool sendNotModified(AsyncWebServerRequest *request, const String &etag);
         AsyncWebServer * getServer(){return server;}
 };
 #endif
\ No newline at end of file
@@ -1,6 +1,284 @@
 #include "GwLog.h"
 #include "GwHardware.h"
+#ifdef ESP_PLATFORM
+#if __has_include(<esp_memory_utils.h>)
+#include <esp_memory_utils.h>
+#else
+#include <soc/soc_memory_layout.h>
+#endif
+#endif
 
+typedef enum{
+    ARG_NONE,   // %%
+    ARG_INT,
+    ARG_LONG,
+    ARG_LONGLONG,
+    ARG_DOUBLE,
+    ARG_STRING,
+    ARG_PTR,
+    ARG_INVALID // something we cannot handle - stop here
+} ArgType;
+
+class FormatSpec{
+    public:
+    const char *start=nullptr;
+    size_t len=0;
+    int stars=0;
+    ArgType type=ARG_INVALID;
+};
+
+/**
+ * parse one printf conversion
+ * p points to the '%'
+ * returns the pointer behind the conversion
+ */
+static const char *parseSpec(const char *p,FormatSpec &spec){
+    spec.start=p;
+    spec.stars=0;
+    spec.type=ARG_INVALID;
+    p++;
+    while (*p && strchr("-+ #0",*p)) p++;
+    if (*p == '*'){
+        spec.stars++;
+        p++;
+    }
+    else{
+        while (*p >= '0' && *p <= '9') p++;
+    }
+    if (*p == '.'){
+        p++;
+        if (*p == '*'){
+            spec.stars++;
+            p++;
+        }
+        else{
+            while (*p >= '0' && *p <= '9') p++;
+        }
+    }
+    int longs=0;
+    bool longDouble=false;
+    while (*p && strchr("hlLzjt",*p)){
+        if (*p == 'l') longs++;
+        if (*p == 'L') longDouble=true;
+        if (*p == 'j') longs=2;
+        if (*p == 'z' || *p == 't') longs=1;
+        p++;
+    }
+    switch(*p){
+        case 'd':
+        case 'i':
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+        case 'c':
+            spec.type=(longs >= 2)?ARG_LONGLONG:((longs == 1)?ARG_LONG:ARG_INT);
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            if (! longDouble) spec.type=ARG_DOUBLE;
+            break;
+        case 's':
+            spec.type=ARG_STRING;
+            break;
+        case 'p':
+            spec.type=ARG_PTR;
+            break;
+        case '%':
+            spec.type=ARG_NONE;
+            break;
+        default:
+            break;
+    }
+    if (*p) p++;
+    spec.len=p-spec.start;
+    return p;
+}
+
+template<typename T> static bool putArg(uint8_t *buffer,size_t size,size_t &len,T v){
+    if ((len+sizeof(T)) > size) return false;
+    memcpy(buffer+len,&v,sizeof(T));
+    len+=sizeof(T);
+    return true;
+}
+template<typename T> static bool getArg(const uint8_t *buffer,size_t len,size_t &pos,T &v){
+    if ((pos+sizeof(T)) > len) return false;
+    memcpy(&v,buffer+pos,sizeof(T));
+    pos+=sizeof(T);
+    return true;
+}
+
+/**
+ * copy the raw arguments for fmt into buffer
+ * strings are copied (truncated if necessary)
+ * returns false if not all arguments fit
+ */
+static bool storeArgs(const char *fmt,va_list args,uint8_t *buffer,size_t size,size_t &len){
+    len=0;
+    const char *p=fmt;
+    while (*p){
+        if (*p != '%'){
+            p++;
+            continue;
+        }
+        FormatSpec spec;
+        p=parseSpec(p,spec);
+        if (spec.type == ARG_INVALID) return false;
+        for (int i=0;i<spec.stars;i++){
+            if (! putArg(buffer,size,len,va_arg(args,int))) return false;
+        }
+        switch(spec.type){
+            case ARG_INT:
+                if (! putArg(buffer,size,len,va_arg(args,int))) return false;
+                break;
+            case ARG_LONG:
+                if (! putArg(buffer,size,len,va_arg(args,long))) return false;
+                break;
+            case ARG_LONGLONG:
+                if (! putArg(buffer,size,len,va_arg(args,long long))) return false;
+                break;
+            case ARG_DOUBLE:
+                if (! putArg(buffer,size,len,va_arg(args,double))) return false;
+                break;
+            case ARG_PTR:
+                if (! putArg(buffer,size,len,va_arg(args,void*))) return false;
+                break;
+            case ARG_STRING:
+                {
+                    const char *s=va_arg(args,const char*);
+                    if (s == nullptr) s="(null)";
+                    if (len >= size) return false;
+                    size_t slen=strlen(s);
+                    bool truncated=false;
+                    if ((len+slen+1) > size){
+                        slen=size-len-1;
+                        truncated=true;
+                    }
+                    memcpy(buffer+len,s,slen);
+                    len+=slen;
+                    buffer[len]=0;
+                    len++;
+                    if (truncated) return false;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    return true;
+}
+
+/**
+ * only formats in flash (string literals) outlive the log call for sure
+ */
+static bool isStaticFormat(const char *fmt){
+#ifdef ESP_PLATFORM
+    return esp_ptr_in_drom(fmt);
+#else
+    return false;
+#endif
+}
+
+/**
+ * format a record from the format string and the stored arguments
+ * we walk the format again and call snprintf for each conversion
+ */
+static void formatArgs(const char *fmt,const uint8_t *args,size_t argLen,bool truncated,char *out,size_t outSize){
+    size_t pos=0;
+    size_t argPos=0;
+    const char *p=fmt;
+    out[0]=0;
+    while (*p && pos < (outSize-1)){
+        if (*p != '%'){
+            out[pos++]=*p++;
+            continue;
+        }
+        FormatSpec spec;
+        const char *next=parseSpec(p,spec);
+        if (spec.type == ARG_INVALID || spec.len > 20) break;
+        //rebuild the conversion with the stored '*' values
+        char conversion[48];
+        size_t cl=0;
+        bool ok=true;
+        for (size_t i=0;i<spec.len && ok;i++){
+            if (spec.start[i] == '*'){
+                int v=0;
+                ok=getArg(args,argLen,argPos,v);
+                cl+=snprintf(conversion+cl,sizeof(conversion)-cl,"%d",v);
+            }
+            else{
+                conversion[cl++]=spec.start[i];
+            }
+        }
+        conversion[cl]=0;
+        if (! ok) break;
+        size_t remain=outSize-pos;
+        int written=0;
+        switch(spec.type){
+            case ARG_NONE:
+                written=snprintf(out+pos,remain,"%%");
+                break;
+            case ARG_INT:{
+                int v;
+                ok=getArg(args,argLen,argPos,v);
+                if (ok) written=snprintf(out+pos,remain,conversion,v);
+                }
+                break;
+            case ARG_LONG:{
+                long v;
+                ok=getArg(args,argLen,argPos,v);
+                if (ok) written=snprintf(out+pos,remain,conversion,v);
+                }
+                break;
+            case ARG_LONGLONG:{
+                long long v;
+                ok=getArg(args,argLen,argPos,v);
+                if (ok) written=snprintf(out+pos,remain,conversion,v);
+                }
+                break;
+            case ARG_DOUBLE:{
+                double v;
+                ok=getArg(args,argLen,argPos,v);
+                if (ok) written=snprintf(out+pos,remain,conversion,v);
+                }
+                break;
+            case ARG_PTR:{
+                void *v;
+                ok=getArg(args,argLen,argPos,v);
+                if (ok) written=snprintf(out+pos,remain,conversion,v);
+                }
+                break;
+            case ARG_STRING:{
+                if (argPos >= argLen){
+                    ok=false;
+                    break;
+                }
+                const char *v=(const char *)(args+argPos);
+                argPos+=strnlen(v,argLen-argPos)+1;
+                written=snprintf(out+pos,remain,conversion,v);
+                }
+                break;
+            default:
+                break;
+        }
+        if (! ok) break;
+        if (written > 0) pos+=written;
+        if (pos >= outSize) pos=outSize-1;
+        p=next;
+    }
+    out[pos]=0;
+    if (truncated){
+        const char *marker="...";
+        size_t ml=strlen(marker);
+        if ((pos+ml) < outSize) memcpy(out+pos,marker,ml+1);
+    }
+}
 
 GwLog::GwLog(int level, GwLogWriter *writer){
     logLevel=level;
@@ -9,6 +287,9 @@ GwLog::GwLog(int level, GwLogWriter *writer){
         iniBuffer=new char[INIBUFFERSIZE];
         iniBuffer[0]=0;
     }
+    head=0;
+    tail=0;
+    dropped=0;
     locker = xSemaphoreCreateMutex();
 }
 GwLog::~GwLog(){
@@ -35,39 +316,120 @@ void GwLog::writeOut(const char *data)
     {
         writer->write(data);
     }
+    if (tailBuffer){
+        for (const char *p=data;*p;p++){
+            tailBuffer[tailPos]=*p;
+            tailPos++;
+            if (tailPos >= TAIL_SIZE){
+                tailPos=0;
+                tailWrapped=true;
+            }
+        }
+    }
+}
+//must be called with the locker held
+void GwLog::writeRecord(unsigned long timestamp,const char *text){
+    recordCounter++;
+    writeOut(prefix.c_str());
+    char buf[20];
+    snprintf(buf,20,"%lu:",timestamp);
+    writeOut(buf);
+    writeOut(text);
+    writeOut("\n");
+}
+bool GwLog::store(int level,const char *fmt,va_list args){
+    uint32_t h=head.load();
+    do{
+        if ((h - tail.load()) >= (uint32_t)RING_SIZE){
+            dropped++;
+            return false;
+        }
+    } while (! head.compare_exchange_weak(h,h+1));
+    Record *r=&ring[h % RING_SIZE];
+    r->timestamp=millis();
+    r->level=level;
+    if (isStaticFormat(fmt)){
+        r->fmt=fmt;
+        size_t len=0;
+        r->truncated=! storeArgs(fmt,args,r->args,ARG_SIZE,len);
+        r->argLen=len;
+    }
+    else{
+        //the format may be gone when we drain, format now
+        r->fmt="%s";
+        int len=vsnprintf((char *)r->args,ARG_SIZE,fmt,args);
+        if (len < 0) len=0;
+        r->truncated=(size_t)len >= ARG_SIZE;
+        r->argLen=r->truncated?ARG_SIZE:len+1;
+    }
+    r->seq.store(h+1,std::memory_order_release);
+    return true;
+}
+//must be called with the locker held, we are the only consumer
+void GwLog::drain(){
+    while (true){
+        uint32_t t=tail.load();
+        if (t == head.load()) break;
+        Record *r=&ring[t % RING_SIZE];
+        if (r->seq.load(std::memory_order_acquire) != (t+1)){
+            //a producer could still be filling this record
+            //wait for it, but do not stall all later records forever
+            if (! waiting || waitingFor != t){
+                waiting=true;
+                waitingFor=t;
+                waitStart=millis();
+                break;
+            }
+            if ((millis()-waitStart) < STALL_TIMEOUT) break;
+            waiting=false;
+            dropped++;
+            tail.store(t+1);
+            continue;
+        }
+        waiting=false;
+        formatArgs(r->fmt,r->args,r->argLen,r->truncated,buffer,bufferSize);
+        unsigned long timestamp=r->timestamp;
+        tail.store(t+1);
+        writeRecord(timestamp,buffer);
+    }
+    uint32_t currentDrops=dropped.load();
+    if (currentDrops != reportedDrops){
+        snprintf(buffer,bufferSize,"%lu log records dropped",(unsigned long)(currentDrops-reportedDrops));
+        reportedDrops=currentDrops;
+        writeRecord(millis(),buffer);
+    }
 }
 void GwLog::logString(const char *fmt,...){
     va_list args;
     va_start(args,fmt);
+    if (ring){
+        store(-1,fmt,args);
+        va_end(args);
+        return;
+    }
     xSemaphoreTake(locker, portMAX_DELAY);
-    recordCounter++;
     vsnprintf(buffer,bufferSize-1,fmt,args);
     buffer[bufferSize-1]=0;
-    writeOut(prefix.c_str());
-    char buf[20];
-    snprintf(buf,20,"%lu:",millis());
-    writeOut(buf);
-    writeOut(buffer);
-    writeOut("\n");
+    writeRecord(millis(),buffer);
     xSemaphoreGive(locker);
+    va_end(args);
 }
 void GwLog::logDebug(int level,const char *fmt,...){
     va_list args;
     va_start(args,fmt);
     logDebug(level,fmt,args);
+    va_end(args);
 }
 void GwLog::logDebug(int level,const char *fmt,va_list args){
-    if (level > logLevel) return;
+    if (! isActive(level)) return;
+    if (ring){
+        store(level,fmt,args);
+        return;
+    }
     xSemaphoreTake(locker, portMAX_DELAY);
-    recordCounter++;
     vsnprintf(buffer,bufferSize-1,fmt,args);
     buffer[bufferSize-1]=0;
-    writeOut(prefix.c_str());
-    char buf[20];
-    snprintf(buf,20,"%lu:",millis());
-    writeOut(buf);
-    writeOut(buffer);
-    writeOut("\n");
+    writeRecord(millis(),buffer);
     xSemaphoreGive(locker);
 }
 void GwLog::setWriter(GwLogWriter *writer){
@@ -83,8 +445,57 @@ void GwLog::setWriter(GwLogWriter *writer){
     xSemaphoreGive(locker);
 }
 
+void GwLog::startAsync(UBaseType_t priority){
+    xSemaphoreTake(locker, portMAX_DELAY);
+    if (ring){
+        xSemaphoreGive(locker);
+        return;
+    }
+    tailBuffer=new char[TAIL_SIZE];
+    Record *newRing=new Record[RING_SIZE];
+    for (int i=0;i<RING_SIZE;i++){
+        newRing[i].seq=0;
+    }
+    ring=newRing;
+    xSemaphoreGive(locker);
+    xTaskCreate([](void *p){
+        GwLog *log=(GwLog *)p;
+        while (true){
+            xSemaphoreTake(log->locker, portMAX_DELAY);
+            log->drain();
+            xSemaphoreGive(log->locker);
+            vTaskDelay(ASYNC_INTERVAL/portTICK_PERIOD_MS);
+        }
+    },"log",4000,this,priority,NULL);
+}
+
+String GwLog::getTail(){
+    String rt;
+    xSemaphoreTake(locker, portMAX_DELAY);
+    if (tailBuffer){
+        rt.reserve(TAIL_SIZE+1);
+        if (tailWrapped){
+            //start at the first complete line
+            size_t start=tailPos;
+            size_t i=0;
+            while (i < TAIL_SIZE && tailBuffer[(start+i) % TAIL_SIZE] != '\n') i++;
+            for (i++;i<TAIL_SIZE;i++){
+                rt+=tailBuffer[(start+i) % TAIL_SIZE];
+            }
+        }
+        else{
+            for (size_t i=0;i<tailPos;i++){
+                rt+=tailBuffer[i];
+            }
+        }
+    }
+    xSemaphoreGive(locker);
+    return rt;
+}
+
 void GwLog::flush(){
     xSemaphoreTake(locker, portMAX_DELAY);
+    if (ring) drain();
     if (! this->writer) {
         xSemaphoreGive(locker);
         return;
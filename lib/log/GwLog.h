@@ -1,6 +1,18 @@
 #ifndef _GWLOG_H
 #define _GWLOG_H
 #include <Arduino.h>
+#include <atomic>
+
+/**
+ * highest log level that is compiled in
+ * all log calls through the macros (and isActive) with a level above
+ * are removed at compile time, e.g. -DGW_LOG_MAX_LEVEL=1 to only keep
+ * errors and info
+ */
+#ifndef GW_LOG_MAX_LEVEL
+#define GW_LOG_MAX_LEVEL 10
+#endif
+#define GW_LOG_ENABLED(level) ((level) <= GW_LOG_MAX_LEVEL)
 
 class GwLogWriter{
     public:
@@ -9,7 +21,37 @@ class GwLogWriter{
         virtual void flush(){};
 };
 class GwLog{
+    public:
+        //async mode: number of records in the ring
+        static const int RING_SIZE=64;
+        //space for the raw arguments of one record
+        //%s arguments are truncated to fit, the output ends with "..." then
+        static const size_t ARG_SIZE=116;
+        //formatted text we keep for /api/log
+        static const size_t TAIL_SIZE=2048;
+        static const unsigned long ASYNC_INTERVAL=20; //ms
+        //skip a record that a producer did not finish within this time (ms)
+        static const unsigned long STALL_TIMEOUT=200;
     private:
+        /**
+         * one binary log record
+         * for formats in flash (literals) the format is only referenced,
+         * the arguments are stored raw (strings copied)
+         * and formatted later in the log task
+         * other formats (e.g. String::c_str() from user tasks) are formatted
+         * directly into args and stored as "%s"
+         * seq is the ring position + 1 when the record is complete
+         */
+        class Record{
+            public:
+            std::atomic<uint32_t> seq;
+            int8_t level;
+            bool truncated;
+            uint8_t argLen;
+            unsigned long timestamp;
+            const char *fmt;
+            uint8_t args[ARG_SIZE];
+        };
         static const size_t bufferSize=250;
         char buffer[bufferSize];
         int logLevel=1;
@@ -19,7 +61,21 @@ class GwLog{
         const size_t INIBUFFERSIZE=1024;
         char *iniBuffer=nullptr;
         size_t iniBufferFill=0;
+        Record *ring=nullptr;
+        std::atomic<uint32_t> head;
+        std::atomic<uint32_t> tail;
+        std::atomic<uint32_t> dropped;
+        uint32_t reportedDrops=0;
+        uint32_t waitingFor=0;
+        unsigned long waitStart=0;
+        bool waiting=false;
+        char *tailBuffer=nullptr;
+        size_t tailPos=0;
+        bool tailWrapped=false;
         void writeOut(const char *data);
+        void writeRecord(unsigned long timestamp,const char *text);
+        bool store(int level,const char *fmt,va_list args);
+        void drain();
     public:
         static const int LOG=1;
         static const int ERROR=0;
@@ -32,13 +88,29 @@ class GwLog{
         void logString(const char *fmt,...);
         void logDebug(int level, const char *fmt,...);
         void logDebug(int level, const char *fmt,va_list ap);
-        int isActive(int level){return level <= logLevel;};
+        int isActive(int level){return GW_LOG_ENABLED(level) && level <= logLevel;};
         void flush();
         void setLevel(int level){this->logLevel=level;}
         long long getRecordCounter(){return recordCounter;}
+        /**
+         * switch to async logging
+         * from now on callers only store binary records into a ring
+         * a low priority task formats and writes them
+         * records are dropped (and counted) if the ring is full
+         * or a producer did not finish its record within STALL_TIMEOUT
+         */
+        void startAsync(UBaseType_t priority=1);
+        bool isAsync(){return ring != nullptr;}
+        unsigned long getDropped(){return dropped.load();}
+        /**
+         * the last TAIL_SIZE bytes of formatted log output
+         */
+        String getTail();
 };
-#define LOG_DEBUG(level,...){ if (logger != NULL && logger->isActive(level)) logger->logDebug(level,__VA_ARGS__);}
+#define LOG_DEBUG(level,...){ if (GW_LOG_ENABLED(level) && logger != NULL && logger->isActive(level)) logger->logDebug(level,__VA_ARGS__);}
 #define LOG_INFO(...){ if (logger != NULL && logger->isActive(GwLog::LOG)) logger->logDebug(GwLog::LOG,__VA_ARGS__);}
 #define LOG_ERROR(...){ if (logger != NULL && logger->isActive(GwLog::ERROR)) logger->logDebug(GwLog::ERROR,__VA_ARGS__);}
+//same as LOG_DEBUG for a GwLog instance (not a pointer)
+#define GW_LOG(log,level,...){ if (GW_LOG_ENABLED(level) && (log).isActive(level)) (log).logDebug(level,__VA_ARGS__);}
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,122 @@
+#ifndef _GWMSGPACK_H
+#define _GWMSGPACK_H
+#include <Arduino.h>
+#include <vector>
+
+/**
+ * minimal MessagePack writer (https://msgpack.org/)
+ * appends to a byte vector, always uses the smallest encoding
+ * maps and arrays must be written with their final number of elements
+ */
+class GwMsgPackWriter{
+    std::vector<uint8_t> &out;
+    void put(uint8_t v){
+        out.push_back(v);
+    }
+    void putBE(uint64_t v,int bytes){
+        for (int i=bytes-1;i>=0;i--){
+            out.push_back((v >> (8*i)) & 0xff);
+        }
+    }
+    void header(uint32_t num,uint8_t fix,uint8_t fixMax,uint8_t c8,uint8_t c16,uint8_t c32){
+        if (num <= fixMax){
+            put(fix | num);
+        }
+        else if (c8 && num <= 0xff){
+            put(c8);
+            put(num);
+        }
+        else if (num <= 0xffff){
+            put(c16);
+            putBE(num,2);
+        }
+        else{
+            put(c32);
+            putBE(num,4);
+        }
+    }
+    public:
+        GwMsgPackWriter(std::vector<uint8_t> &o):out(o){}
+        size_t size() const{ return out.size();}
+        void nil(){
+            put(0xc0);
+        }
+        void boolean(bool v){
+            put(v?0xc3:0xc2);
+        }
+        void map(uint32_t num){
+            header(num,0x80,15,0,0xde,0xdf);
+        }
+        void array(uint32_t num){
+            header(num,0x90,15,0,0xdc,0xdd);
+        }
+        void str(const char *s,size_t len){
+            header(len,0xa0,31,0xd9,0xda,0xdb);
+            out.insert(out.end(),(const uint8_t*)s,(const uint8_t*)s+len);
+        }
+        void str(const char *s){
+            str(s,strlen(s));
+        }
+        void str(const String &s){
+            str(s.c_str(),s.length());
+        }
+        void uint(uint64_t v){
+            if (v < 128){
+                put(v);
+            }
+            else if (v <= 0xff){
+                put(0xcc);
+                put(v);
+            }
+            else if (v <= 0xffff){
+                put(0xcd);
+                putBE(v,2);
+            }
+            else if (v <= 0xffffffffULL){
+                put(0xce);
+                putBE(v,4);
+            }
+            else{
+                put(0xcf);
+                putBE(v,8);
+            }
+        }
+        void integer(int64_t v){
+            if (v >= 0){
+                uint(v);
+                return;
+            }
+            if (v >= -32){
+                put((uint8_t)(int8_t)v);
+            }
+            else if (v >= -128){
+                put(0xd0);
+                put((uint8_t)(int8_t)v);
+            }
+            else if (v >= -32768){
+                put(0xd1);
+                putBE((uint16_t)(int16_t)v,2);
+            }
+            else if (v >= -2147483648LL){
+                put(0xd2);
+                putBE((uint32_t)(int32_t)v,4);
+            }
+            else{
+                put(0xd3);
+                putBE((uint64_t)v,8);
+            }
+        }
+        void f32(float v){
+            uint32_t bits;
+            memcpy(&bits,&v,4);
+            put(0xca);
+            putBE(bits,4);
+        }
+        void f64(double v){
+            uint64_t bits;
+            memcpy(&bits,&v,8);
+            put(0xcb);
+            putBE(bits,8);
+        }
+};
+#endif
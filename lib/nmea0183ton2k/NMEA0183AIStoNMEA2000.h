@@ -110,13 +110,13 @@ class MyAisDecoder : public AIS::AisDecoder
       //Serial.println("411");
     }
 
-    virtual void onType5(unsigned int _uMsgType, unsigned int _uMmsi, unsigned int _uImo, const std::string &_strCallsign,
-                         const std::string &_strName,
+    virtual void onType5(unsigned int _uMsgType, unsigned int _uMmsi, unsigned int _uImo, const char *_strCallsign,
+                         const char *_strName,
                          unsigned int _uType, unsigned int _uToBow, unsigned int _uToStern,
                          unsigned int _uToPort, unsigned int _uToStarboard, unsigned int _uFixType,
                          unsigned int _uEtaMonth, unsigned int _uEtaDay, unsigned int _uEtaHour,
                          unsigned int _uEtaMinute, unsigned int _uDraught,
-                         const std::string &_strDestination, unsigned int _ais_version,
+                         const char *_strDestination, unsigned int _ais_version,
                          unsigned int _repeat, bool _dte) override {
 
       // Serial.println("5");
@@ -143,15 +143,15 @@ class MyAisDecoder : public AIS::AisDecoder
       char Name[21];
       char Dest[21];
 
-      strncpy(CS, _strCallsign.c_str(), sizeof(CS) - 1);
+      strncpy(CS, _strCallsign, sizeof(CS) - 1);
       CS[7] = 0;
       for (int i = strlen(CS); i < 7; i++) CS[i] = 32;
 
-      strncpy(Name, _strName.c_str(), sizeof(Name) - 1);
+      strncpy(Name, _strName, sizeof(Name) - 1);
       Name[20] = 0;
       for (int i = strlen(Name); i < 20; i++) Name[i] = 32;
 
-      strncpy(Dest, _strDestination.c_str(), sizeof(Dest) - 1);
+      strncpy(Dest, _strDestination, sizeof(Dest) - 1);
       Dest[20] = 0;
       for (int i = strlen(Dest); i < 20; i++) Dest[i] = 32;
       
@@ -171,11 +171,11 @@ class MyAisDecoder : public AIS::AisDecoder
     }
 
     virtual void onType14(unsigned int _repeat, unsigned int _uMmsi,
-                          const std::string &_strText, int _iPayloadSizeBits) override {
+                          const char *_strText, int _iPayloadSizeBits) override {
 
       tN2kMsg N2kMsg;
       char Text[162];
-      strncpy(Text, _strText.c_str(), sizeof(Text)-1);
+      strncpy(Text, _strText, sizeof(Text)-1);
       Text[161]=0;
 
       N2kMsg.SetPGN(129802UL);
@@ -215,7 +215,7 @@ class MyAisDecoder : public AIS::AisDecoder
     }
 
     virtual void onType19(unsigned int _uMmsi, unsigned int _uSog, bool _bPosAccuracy, int _iPosLon, int _iPosLat,
-                          int _iCog, int _iHeading, const std::string &_strName, unsigned int _uType,
+                          int _iCog, int _iHeading, const char *_strName, unsigned int _uType,
                           unsigned int _uToBow, unsigned int _uToStern, unsigned int _uToPort,
                           unsigned int _uToStarboard, unsigned int _timestamp, unsigned int _fixtype,
                           bool _dte, bool _assigned, unsigned int _repeat, bool _raim) override {
@@ -226,7 +226,7 @@ class MyAisDecoder : public AIS::AisDecoder
       // PGN129040
 
       char Name[21];
-      strncpy(Name, _strName.c_str(), sizeof(Name)-1);
+      strncpy(Name, _strName, sizeof(Name)-1);
       Name[20]=0;
       for (int i = strlen(Name); i < 20; i++) Name[i] = 32;
 
@@ -257,7 +257,7 @@ class MyAisDecoder : public AIS::AisDecoder
     }
 
     //mmsi, aidType, name + nameExt, posAccuracy, posLon, posLat, toBow, toStern, toPort, toStarboard
-    virtual void onType21(unsigned int mmsi , unsigned int aidType , const std::string & name, bool accuracy, int posLon, int posLat, unsigned int toBow, 
+    virtual void onType21(unsigned int mmsi , unsigned int aidType , const char * name, bool accuracy, int posLon, int posLat, unsigned int toBow, 
       unsigned int toStern, unsigned int toPort, unsigned int toStarboard,
       unsigned int repeat,unsigned int timestamp, bool raim, bool virtualAton, bool offPosition) override {
       //Serial.println("21");
@@ -288,17 +288,17 @@ class MyAisDecoder : public AIS::AisDecoder
       N2kMsg.AddByte((transceiverInfo & 0x1f) | 0xe0);
       //bit offset 208 (see canboat/pgns.xml) -> 26 bytes from start
       //as MaxDataLen is 223 and the string can be at most 36 bytes + 2 byte heading - no further check here 
-      N2kMsg.AddVarStr(name.c_str());
+      N2kMsg.AddVarStr(name);
       send(N2kMsg);
     }
 
     virtual void onType24A(unsigned int _uMsgType, unsigned int _repeat, unsigned int _uMmsi,
-                           const std::string &_strName) override {
+                           const char *_strName) override {
       //Serial.println("24A");
 
       tN2kMsg N2kMsg;
       char Name[21];
-      strncpy(Name, _strName.c_str(), sizeof(Name) - 1);
+      strncpy(Name, _strName, sizeof(Name) - 1);
       Name[20]=0;
       for (int i = strlen(Name); i < 20; i++) Name[i] = 32;
       
@@ -310,9 +310,9 @@ class MyAisDecoder : public AIS::AisDecoder
     }
 
     virtual void onType24B(unsigned int _uMsgType, unsigned int _repeat, unsigned int _uMmsi,
-                           const std::string &_strCallsign, unsigned int _uType,
+                           const char *_strCallsign, unsigned int _uType,
                            unsigned int _uToBow, unsigned int _uToStern, unsigned int _uToPort,
-                           unsigned int _uToStarboard, const std::string &_strVendor) override {
+                           unsigned int _uToStarboard, const char *_strVendor) override {
 
       // Serial.println("24B");
 
@@ -321,10 +321,10 @@ class MyAisDecoder : public AIS::AisDecoder
       char CS[8];
       char Vendor[8];
 
-      strncpy(CS, _strCallsign.c_str(), sizeof(CS) - 1);
+      strncpy(CS, _strCallsign, sizeof(CS) - 1);
       CS[7] = 0;
       for (int i = strlen(CS); i < 7; i++) CS[i] = 32;
-      strncpy(Vendor, _strVendor.c_str(), sizeof(Vendor) - 1);
+      strncpy(Vendor, _strVendor, sizeof(Vendor) - 1);
       Vendor[7] = 0;
       for (int i = strlen(Vendor); i < 7; i++) Vendor[i] = 32;
 
@@ -350,21 +350,40 @@ class MyAisDecoder : public AIS::AisDecoder
 
     virtual void onNotDecoded(const AIS::StringRef &, int ) override {}
 
-    virtual void onDecodeError(const AIS::StringRef &_strMessage, const std::string &_strError) override {
-      std::string msg(_strMessage.data(), _strMessage.size());
-      AIS::stripTrailingWhitespace(msg);
-
-      LOG_DEBUG(GwLog::ERROR,"%s [%s]\n", _strError.c_str(), msg.c_str());
+    //log without a heap copy of the message
+    void logError(const AIS::StringRef &_strMessage, const char *_strError){
+      if (! logger->isActive(GwLog::ERROR)) return;
+      char msg[AIS::MAX_LINE_LENGTH+1];
+      size_t len=_strMessage.size();
+      if (len > AIS::MAX_LINE_LENGTH) len=AIS::MAX_LINE_LENGTH;
+      while (len > 0 && AIS::ascii_isspace(_strMessage[len-1])) len--;
+      memcpy(msg,_strMessage.data(),len);
+      msg[len]=0;
+      LOG_DEBUG(GwLog::ERROR,"%s [%s]\n", _strError, msg);
     }
 
-    virtual void onParseError(const AIS::StringRef &_strMessage, const std::string &_strError) override {
-      std::string msg(_strMessage.data(), _strMessage.size());
-      AIS::stripTrailingWhitespace(msg);
+    virtual void onDecodeError(const AIS::StringRef &_strMessage, const char *_strError) override {
+      logError(_strMessage,_strError);
+    }
 
-      LOG_DEBUG(GwLog::ERROR,"%s [%s]\n", _strError.c_str(), msg.c_str());
+    virtual void onParseError(const AIS::StringRef &_strMessage, const char *_strError) override {
+      logError(_strMessage,_strError);
     }
   public:
     void handleMessage(const char * msg){
-      size_t i=decodeMsg(msg,strlen(msg),0,parser,true);
+      size_t i=decodeMsg(msg,strlen(msg),0,parser,true,sourceId,millis());
+    }
+    void toJson(GwJsonDocument &json){
+      JsonObject jo=json.createNestedObject("aisDecoder");
+      jo["messages"]=getTotalMessageCount();
+      jo["crcErrors"]=getCrcErrorCount();
+      jo["errors"]=getDecodingErrorCount();
+      jo["orphaned"]=getOrphanedFragmentCount();
+      jo["incomplete"]=getIncompleteMessageCount();
+      jo["timedOut"]=getTimedOutMessageCount();
+      jo["evicted"]=getEvictedMessageCount();
+    }
+    static int getJsonSize(){
+      return JSON_OBJECT_SIZE(1)+JSON_OBJECT_SIZE(7);
     }
 };
@@ -464,7 +464,7 @@ private:
         }
         if (WindSpeed == NMEA0183DoubleNA)
         {
-            logger->logDebug(GwLog::DEBUG, "no wind speed in VWR %s", msg.line);
+            LOG_DEBUG(GwLog::DEBUG, "no wind speed in VWR %s", msg.line);
             return;
         }
         tN2kMsg n2kMsg;
@@ -508,7 +508,7 @@ private:
         }
         if (WindSpeed == NMEA0183DoubleNA)
         {
-            logger->logDebug(GwLog::DEBUG, "no wind speed in MWD %s", msg.line);
+            LOG_DEBUG(GwLog::DEBUG, "no wind speed in MWD %s", msg.line);
             return;
         }
         tN2kMsg n2kMsg;
@@ -665,11 +665,11 @@ private:
                 double dbt=boatData->DBT->getData();
                 double offset=Depth-dbt;
                 if (offset >= 0 && dt == DBK){
-                    logger->logDebug(GwLog::DEBUG, "strange DBK - more depth then transducer %s", msg.line);    
+                    LOG_DEBUG(GwLog::DEBUG, "strange DBK - more depth then transducer %s", msg.line);    
                     return;
                 }
                 if (offset < 0 && dt == DBS){
-                    logger->logDebug(GwLog::DEBUG, "strange DBS - less depth then transducer %s", msg.line);    
+                    LOG_DEBUG(GwLog::DEBUG, "strange DBS - less depth then transducer %s", msg.line);    
                     return;
                 }
                 if (dt == DBS){
@@ -1094,6 +1094,12 @@ public:
     virtual String handledKeys(){
         return converters.handledKeys();
     }
+    virtual int getJsonSize(){
+        return MyAisDecoder::getJsonSize();
+    }
+    virtual void toJson(GwJsonDocument &json){
+        aisDecoder->toJson(json);
+    }
 
     NMEA0183DataToN2KFunctions(GwLog *logger, GwBoatData *boatData, N2kSender callback, 
         GwXDRMappings *xdrMappings,
@@ -5,6 +5,7 @@
 #include "N2kMessages.h"
 #include "GwXDRMappings.h"
 #include "GwConverterConfig.h"
+#include "GwJsonDocument.h"
 
 class NMEA0183DataToN2K{
     public:
@@ -22,6 +23,11 @@ class NMEA0183DataToN2K{
         virtual int numConverters()=0;
         virtual String handledKeys()=0;
         unsigned long getLastRmc()const {return lastRmc; }
+        /**
+         * converter statistics (AIS decoder) for the status
+         */
+        virtual int getJsonSize(){ return 0;}
+        virtual void toJson(GwJsonDocument &json){}
         static NMEA0183DataToN2K* create(GwLog *logger,GwBoatData *boatData,N2kSender callback,
             GwXDRMappings *xdrMappings,
             const GwConverterConfig &config);
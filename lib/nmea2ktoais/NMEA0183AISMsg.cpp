@@ -35,6 +35,17 @@ OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 const char AsciiChar[] = "@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_ !\"#$%&\'()*+,-./0123456789:;<=>?";
 const char *tNMEA0183AISMsg::EmptyAISField = "000000";
 
+// 6 bit value -> payload character (0..39: +48, 40..63: +56)
+static const char ArmorChar[] =
+  "0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVW`abcdefghijklmnopqrstuvw";
+
+// index of a character in AsciiChar, 0 ("@") for characters not in the table
+static inline uint8_t SixBitChar(char c) {
+  uint8_t u = (uint8_t)c;
+  if ( u < 32 || u > 95 ) return 0;
+  return u < 64 ? u : u - 64;
+}
+
 //*****************************************************************************
 tNMEA0183AISMsg::tNMEA0183AISMsg() {
   ClearAIS();
@@ -44,27 +55,38 @@ tNMEA0183AISMsg::tNMEA0183AISMsg() {
 void tNMEA0183AISMsg::ClearAIS() {
 
   Payload[0]=0;
-  PayloadBin.reset();
+  bitAcc=0;
+  bitAccLen=0;
   iAddPldBin=0;
   iAddPld=0;
 }
 
+//*****************************************************************************
+// append the lower countBits (max 32) of val, full bytes go to PayloadBin
+void tNMEA0183AISMsg::AddBitsToPayloadBin(uint32_t val, uint8_t countBits) {
+  if ( countBits < 32 ) val &= (((uint32_t)1) << countBits) - 1;
+  bitAcc = (bitAcc << countBits) | val;
+  bitAccLen += countBits;
+  uint16_t iByte = (iAddPldBin >> 3);
+  while ( bitAccLen >= 8 ) {
+    bitAccLen -= 8;
+    PayloadBin[iByte++] = (uint8_t)(bitAcc >> bitAccLen);
+  }
+  iAddPldBin += countBits;
+}
 
 //*****************************************************************************
 bool tNMEA0183AISMsg::AddIntToPayloadBin(int32_t ival, uint16_t countBits) {
 
   if ( (iAddPldBin + countBits ) >= AIS_BIN_MAX_LEN ) return false; // Is there room for any data
 
-  bset = ival;
-
-  uint16_t iAdd=iAddPldBin;
-
-  for(int i = countBits-1; i >= 0 ; i--) {
-    PayloadBin[iAdd]=bset [i];
-    iAdd++;
+  // more than 32 bits: sign extension
+  while ( countBits > 32 ) {
+    uint8_t num = countBits - 32 > 32 ? 32 : countBits - 32;
+    AddBitsToPayloadBin(ival < 0 ? 0xffffffff : 0, num);
+    countBits -= num;
   }
-
-  iAddPldBin += countBits;
+  AddBitsToPayloadBin((uint32_t)ival, countBits);
 
   return true;
 }
@@ -72,8 +94,7 @@ bool tNMEA0183AISMsg::AddIntToPayloadBin(int32_t ival, uint16_t countBits) {
 //****************************************************************************
 bool tNMEA0183AISMsg::AddBoolToPayloadBin(bool &bval) {
   if ( (iAddPldBin + 1 ) >= AIS_BIN_MAX_LEN ) return false;
-  PayloadBin[iAddPldBin]=bval;
-  iAddPldBin++; 
+  AddBitsToPayloadBin(bval ? 1 : 0, 1);
   return true;
 }
 
@@ -84,65 +105,66 @@ bool tNMEA0183AISMsg::AddEncodedCharToPayloadBin(char *sval, size_t countBits) {
 
   if ( (iAddPldBin + countBits ) >= AIS_BIN_MAX_LEN ) return false; // Is there room for any data
 
-  const char * ptr;
   size_t len = strlen(sval);  // e.g.: should be 7 for Callsign
   if ( len * 6 > countBits ) len = countBits / 6;
 
-  for (size_t i = 0; i<len; i++) {
-
-    ptr = strchr(AsciiChar, sval[i]);
-    if ( ptr ) {
-      int16_t index = ptr - AsciiChar;
-      if (index >= 0){
-        AddIntToPayloadBin(index, 6);
-      }
-    } else {
-      AddIntToPayloadBin(0, 6);
+  // 5 characters (30 bit) at once
+  size_t i = 0;
+  for (; i + 5 <= len; i += 5) {
+    uint32_t v = 0;
+    for (size_t k = i; k < i + 5; k++) {
+      v = (v << 6) | SixBitChar(sval[k]);
     }
+    AddBitsToPayloadBin(v, 30);
+  }
+  for (; i < len; i++) {
+    AddBitsToPayloadBin(SixBitChar(sval[i]), 6);
   }
   // fill up with "@", also covers empty sval
   if ( len * 6 < countBits ) {
-    for (size_t i=0;i<(countBits/6-len);i++) {
-      AddIntToPayloadBin(0, 6);
+    size_t fill = (countBits/6-len)*6;
+    while ( fill > 0 ) {
+      uint8_t num = fill > 30 ? 30 : fill;
+      AddBitsToPayloadBin(0, num);
+      fill -= num;
     }
   }
   return true;
 }
 
 //*****************************************************************************
-template <unsigned int S>
-int tNMEA0183AISMsg::ConvertBinaryAISPayloadBinToAscii(std::bitset<S> &src,uint16_t maxSize,uint16_t bitSize,uint16_t stoffset) {
+int tNMEA0183AISMsg::ConvertBinaryAISPayloadBinToAscii(uint16_t maxSize,uint16_t bitSize,uint16_t stoffset) {
   Payload[0]='\0';
   uint16_t slen=maxSize;
   if (stoffset >= slen) return 0;
+  // write the pending bits (zero filled) to have all data in PayloadBin
+  if ( bitAccLen > 0 ) {
+    PayloadBin[iAddPldBin >> 3] = (uint8_t)(bitAcc << (8 - bitAccLen));
+  }
   slen-=stoffset;
   uint16_t bitLen=bitSize > 0?bitSize:slen;
-  uint16_t len= bitLen / 6; 
+  uint16_t len= bitLen / 6;
   if ((len * 6) < bitLen) len+=1;
-  uint16_t padBits=0; 
-  uint32_t offset;
-  std::bitset<6> s;
-  uint8_t dec;
+  uint16_t padBits=0;
+  uint16_t end=stoffset+slen;
+  uint16_t pos=stoffset;
   int i;
-  for ( i=0; i<len; i++ ) {
-    offset = i * 6;
-    int k = 5;
-    for (uint32_t j=offset; j<offset+6; j++ ) {
-      if (j < slen){
-        s[k] = src[stoffset+j];
-      }
-      else{
-        s[k] = 0;
-        padBits++;
+  for ( i=0; i<len; i++, pos+=6 ) {
+    uint8_t dec=0;
+    if ( pos < end ) {
+      // the 6 bits are always within 2 bytes
+      uint16_t w = (((uint16_t)PayloadBin[pos >> 3]) << 8) | PayloadBin[(pos >> 3) + 1];
+      dec = (w >> (10 - (pos & 7))) & 0x3f;
+      if ( pos + 6 > end ) {
+        uint8_t pad = pos + 6 - end;
+        dec &= (0x3f << pad) & 0x3f;
+        padBits += pad;
       }
-      k--;
     }
-    dec = s.to_ulong();
-
-    if (dec < 40 ) dec += 48;
-    else dec += 56;
-    char c = dec;
-    Payload[i] = c;
+    else {
+      padBits += 6;
+    }
+    Payload[i] = ArmorChar[dec];
   }
   Payload[i]=0;
 
@@ -195,7 +217,7 @@ const char *tNMEA0183AISMsg::GetPayloadFix(int &padBits,uint16_t fixLen){
   return GetPayload(padBits,0,0);
 }
 const char *tNMEA0183AISMsg::GetPayload(int &padBits,uint16_t offset,uint16_t bitLen) {
-  padBits=ConvertBinaryAISPayloadBinToAscii<AIS_BIN_MAX_LEN>(PayloadBin,iAddPldBin, bitLen,offset );
+  padBits=ConvertBinaryAISPayloadBinToAscii(iAddPldBin, bitLen,offset );
   return Payload;
 }
 
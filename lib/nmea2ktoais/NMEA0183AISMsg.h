@@ -29,7 +29,6 @@ OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <NMEA0183Msg.h>
 #include <string.h>
 #include <time.h>
-#include <bitset>
 #include <stdint.h>
 #include <math.h>
 #include <string>
@@ -43,12 +42,9 @@ OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #define AIS_BIN_MAX_LEN 500  // maximum length of AIS Binary Payload (before encoding to Ascii)
 #endif
 
-#define BITSET_LENGTH 120
-
 class tNMEA0183AISMsg : public tNMEA0183Msg {
 
   protected:  // AIS-NMEA
-    std::bitset<BITSET_LENGTH> bset;
     static const char *EmptyAISField;  // 6bits 0      not used yet.....
     static const char *AsciChar;
 
@@ -57,7 +53,12 @@ class tNMEA0183AISMsg : public tNMEA0183Msg {
     uint8_t  iAddPld;
     char talker[4]="VDM";
     char channel[2]="A";
-    std::bitset<AIS_BIN_MAX_LEN> PayloadBin;
+    // binary payload, MSB first, 2 extra bytes to read 6 bits at any position
+    uint8_t PayloadBin[AIS_BIN_MAX_LEN/8+2];
+    // bits not yet written to PayloadBin (less than 8 after each add)
+    uint64_t bitAcc;
+    uint8_t bitAccLen;
+    void AddBitsToPayloadBin(uint32_t val, uint8_t countBits);
   public:
     // Clear message
     void ClearAIS();
@@ -83,10 +84,10 @@ class tNMEA0183AISMsg : public tNMEA0183Msg {
     /**
      * convert the payload to ascii
      * return the number of padding bits
+     * @param maxSize the number of valid bits in PayloadBin
      * @param bitSize the number of bits to be used, 0 - use all bits
      */
-    template  <unsigned int SZ>
-    int ConvertBinaryAISPayloadBinToAscii(std::bitset<SZ> &src,uint16_t maxSize, uint16_t bitSize,uint16_t offset=0);
+    int ConvertBinaryAISPayloadBinToAscii(uint16_t maxSize, uint16_t bitSize,uint16_t offset=0);
 
   // AIS Helper functions
   protected:
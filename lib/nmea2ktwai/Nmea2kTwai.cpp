@@ -1,22 +1,44 @@
 #include "Nmea2kTwai.h"
+#ifndef GW_N2K_SOCKETCAN
 #include "driver/gpio.h"
 #include "driver/twai.h"
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <linux/can/error.h>
+#endif
 
 #define LOGID(id) ((id >> 8) & 0x1ffff)
+//per frame logging, LOG_MSG is mapped to GwLog::DEBUG+1
+#if defined(GW_LOG_MAX_LEVEL) && GW_LOG_MAX_LEVEL < 4
+#define LOG_FRAME(...)
+#else
+#define LOG_FRAME(...) { if (isLogActive(LOG_MSG)) logDebug(LOG_MSG,__VA_ARGS__);}
+#endif
 
 static const int TIMEOUT_OFFLINE=256; //# of timeouts to consider offline
 
 Nmea2kTwai::Nmea2kTwai(gpio_num_t _TxPin,  gpio_num_t _RxPin, unsigned long recP, unsigned long logP):
      tNMEA2000(),RxPin(_RxPin),TxPin(_TxPin)
 {
+#ifndef GW_N2K_SOCKETCAN
     if (RxPin < 0 || TxPin < 0){
         disabled=true;    
     }
-    else{
+    else
+#endif
+    {
         timers.addAction(logP,[this](){logStatus();});
         timers.addAction(recP,[this](){checkRecovery();});
     }
 }
+#ifndef GW_N2K_SOCKETCAN
 
 bool Nmea2kTwai::CANSendFrame(unsigned long id, unsigned char len, const unsigned char *buf, bool wait_sent)
 {
@@ -32,11 +54,11 @@ bool Nmea2kTwai::CANSendFrame(unsigned long id, unsigned char len, const unsigne
         if (rt == ESP_ERR_TIMEOUT){
             if (txTimeouts < TIMEOUT_OFFLINE) txTimeouts++;
         }
-        logDebug(LOG_MSG,"twai transmit for %ld failed: %x",LOGID(id),(int)rt);
+        LOG_FRAME("twai transmit for %ld failed: %x",LOGID(id),(int)rt);
         return false;
     }
     txTimeouts=0;
-    logDebug(LOG_MSG,"twai transmit id %ld, len %d",LOGID(id),(int)len);
+    LOG_FRAME("twai transmit id %ld, len %d",LOGID(id),(int)len);
     return true;
 }
 bool Nmea2kTwai::CANOpen()
@@ -72,7 +94,7 @@ bool Nmea2kTwai::CANGetFrame(unsigned long &id, unsigned char &len, unsigned cha
         logDebug(LOG_DEBUG,"twai: received invalid message %lld, len %d",LOGID(id),len);
         len=8;
     }
-    logDebug(LOG_MSG,"twai rcv id=%ld,len=%d, ext=%d",LOGID(message.identifier),message.data_length_code,message.extd);
+    LOG_FRAME("twai rcv id=%ld,len=%d, ext=%d",LOGID(message.identifier),message.data_length_code,message.extd);
     if (! message.rtr){
         memcpy(buf,message.data,message.data_length_code);
     }
@@ -92,18 +114,11 @@ void Nmea2kTwai::initDriver(){
         logDebug(LOG_ERR,"twai driver init failed: %x",(int)rt);
     }
 }
-// This will be called on Open() before any other initialization. Inherit this, if buffers can be set for the driver
-// and you want to change size of library send frame buffer size. See e.g. NMEA2000_teensy.cpp.
-void Nmea2kTwai::InitCANFrameBuffers()
-{
-    if (disabled){
-        logDebug(LOG_INFO,"twai init - disabled");
-    }
-    else{
-        initDriver();
+void Nmea2kTwai::deinitDriver(){
+    esp_err_t rt=twai_driver_uninstall();
+    if (rt != ESP_OK){
+        logDebug(LOG_ERR,"twai: deinit for recovery failed with %x",(int)rt);
     }
-    tNMEA2000::InitCANFrameBuffers();
-    
 }
 Nmea2kTwai::Status Nmea2kTwai::getStatus(){
     twai_status_info_t state;
@@ -140,6 +155,203 @@ Nmea2kTwai::Status Nmea2kTwai::getStatus(){
     }
     return rt;
 }
+#else
+/**
+ * SocketCAN variant of the driver hooks
+ * allows to run the N2K side on a linux host
+ * e.g. with a vcan0 interface and canplayer
+ */
+/**
+ * errors that need a new socket (interface removed or down)
+ * we close the socket, the state becomes STOPPED and the
+ * recovery timer re-creates it via CANOpen
+ */
+static bool isInterfaceError(int err){
+    return err == ENETDOWN || err == ENODEV || err == ENXIO || err == EBADF;
+}
+void Nmea2kTwai::handleErrorFrame(unsigned long id, unsigned char len, const unsigned char *buf){
+    if (id & CAN_ERR_BUSOFF){
+        if (socketStatus.state != ST_BUS_OFF){
+            logDebug(LOG_ERR,"socketcan: bus off");
+        }
+        socketStatus.state=ST_BUS_OFF;
+    }
+    if (id & CAN_ERR_RESTARTED){
+        logDebug(LOG_INFO,"socketcan: controller restarted");
+        socketStatus.state=ST_RUNNING;
+    }
+    if (id & CAN_ERR_TX_TIMEOUT){
+        socketStatus.tx_failed++;
+    }
+    if ((id & CAN_ERR_CRTL) && len > 1){
+        if (buf[1] & (CAN_ERR_CRTL_RX_OVERFLOW | CAN_ERR_CRTL_TX_OVERFLOW)){
+            socketStatus.rx_overrun++;
+        }
+    }
+#ifdef CAN_ERR_CNT
+    if ((id & CAN_ERR_CNT) && len > 7){
+        socketStatus.tx_errors=buf[6];
+        socketStatus.rx_errors=buf[7];
+    }
+#endif
+}
+bool Nmea2kTwai::CANSendFrame(unsigned long id, unsigned char len, const unsigned char *buf, bool wait_sent)
+{
+    if (disabled) return true;
+    if (canSocket < 0) return false;
+    struct can_frame frame;
+    memset(&frame,0,sizeof(frame));
+    frame.can_id=(id & CAN_EFF_MASK) | CAN_EFF_FLAG;
+    if (len > 8) len=8;
+    frame.can_dlc=len;
+    memcpy(frame.data,buf,len);
+    ssize_t rt=::write(canSocket,&frame,sizeof(frame));
+    if (rt != sizeof(frame)){
+        if (rt < 0 && (errno == EAGAIN || errno == ENOBUFS)){
+            if (txTimeouts < TIMEOUT_OFFLINE) txTimeouts++;
+        }
+        else if (rt < 0 && isInterfaceError(errno)){
+            logDebug(LOG_ERR,"socketcan: write error %d, closing socket",errno);
+            deinitDriver();
+        }
+        else{
+            socketStatus.tx_failed++;
+        }
+        LOG_FRAME("socketcan transmit for %ld failed: %d",LOGID(id),errno);
+        return false;
+    }
+    txTimeouts=0;
+    LOG_FRAME("socketcan transmit id %ld, len %d",LOGID(id),(int)len);
+    return true;
+}
+bool Nmea2kTwai::CANOpen()
+{
+    if (disabled){
+        logDebug(LOG_INFO,"CAN disabled");
+        return true;
+    }
+    if (canSocket < 0){
+        //interface was missing at start or has gone away
+        initDriver();
+    }
+    if (canSocket < 0){
+        logDebug(LOG_ERR,"CANOpen failed: no socket for %s",GW_N2K_SOCKETCAN);
+        return false;
+    }
+    socketStatus.state=ST_RUNNING;
+    logDebug(LOG_INFO,"CANOpen ok");
+    return true;
+}
+bool Nmea2kTwai::CANGetFrame(unsigned long &id, unsigned char &len, unsigned char *buf)
+{
+    if (disabled) return false;
+    if (canSocket < 0) return false;
+    struct can_frame frame;
+    while (true){
+        ssize_t rt=::read(canSocket,&frame,sizeof(frame));
+        if (rt != sizeof(frame)){
+            if (rt < 0 && isInterfaceError(errno)){
+                logDebug(LOG_ERR,"socketcan: read error %d, closing socket",errno);
+                deinitDriver();
+            }
+            else if (rt < 0 && errno != EAGAIN && errno != EWOULDBLOCK){
+                logDebug(LOG_DEBUG,"socketcan: read error %d",errno);
+            }
+            return false;
+        }
+        if (frame.can_id & CAN_ERR_FLAG){
+            handleErrorFrame(frame.can_id & CAN_ERR_MASK,frame.can_dlc,frame.data);
+            continue;
+        }
+        break;
+    }
+    if (! (frame.can_id & CAN_EFF_FLAG)){
+        return false;
+    }
+    id=frame.can_id & CAN_EFF_MASK;
+    len=frame.can_dlc;
+    if (len > 8){
+        logDebug(LOG_DEBUG,"socketcan: received invalid message %ld, len %d",LOGID(id),len);
+        len=8;
+    }
+    LOG_FRAME("socketcan rcv id=%ld,len=%d",LOGID(id),(int)len);
+    if (! (frame.can_id & CAN_RTR_FLAG)){
+        memcpy(buf,frame.data,len);
+    }
+    return true;
+}
+void Nmea2kTwai::initDriver(){
+    if (disabled) return;
+    socketStatus=Status();
+    socketStatus.state=ST_STOPPED;
+    canSocket=socket(PF_CAN,SOCK_RAW,CAN_RAW);
+    if (canSocket < 0){
+        logDebug(LOG_ERR,"socketcan: unable to create socket: %d",errno);
+        return;
+    }
+    struct ifreq ifr;
+    memset(&ifr,0,sizeof(ifr));
+    strncpy(ifr.ifr_name,GW_N2K_SOCKETCAN,IFNAMSIZ-1);
+    if (ioctl(canSocket,SIOCGIFINDEX,&ifr) < 0){
+        logDebug(LOG_ERR,"socketcan: unknown interface %s: %d",GW_N2K_SOCKETCAN,errno);
+        deinitDriver();
+        return;
+    }
+    can_err_mask_t errMask=CAN_ERR_TX_TIMEOUT | CAN_ERR_CRTL | CAN_ERR_BUSOFF | CAN_ERR_RESTARTED;
+#ifdef CAN_ERR_CNT
+    errMask|=CAN_ERR_CNT;
+#endif
+    setsockopt(canSocket,SOL_CAN_RAW,CAN_RAW_ERR_FILTER,&errMask,sizeof(errMask));
+    fcntl(canSocket,F_SETFL,fcntl(canSocket,F_GETFL,0) | O_NONBLOCK);
+    struct sockaddr_can addr;
+    memset(&addr,0,sizeof(addr));
+    addr.can_family=AF_CAN;
+    addr.can_ifindex=ifr.ifr_ifindex;
+    if (bind(canSocket,(struct sockaddr *)&addr,sizeof(addr)) < 0){
+        logDebug(LOG_ERR,"socketcan: bind to %s failed: %d",GW_N2K_SOCKETCAN,errno);
+        deinitDriver();
+        return;
+    }
+    logDebug(LOG_INFO,"socketcan driver initialzed, if=%s",GW_N2K_SOCKETCAN);
+}
+void Nmea2kTwai::deinitDriver(){
+    if (canSocket >= 0){
+        ::close(canSocket);
+    }
+    canSocket=-1;
+    socketStatus.state=ST_STOPPED;
+}
+Nmea2kTwai::Status Nmea2kTwai::getStatus(){
+    Status rt;
+    if (disabled){
+        rt.state=ST_DISABLED;
+        return rt;
+    }
+    if (canSocket < 0){
+        rt.state=ST_STOPPED;
+        return rt;
+    }
+    rt=socketStatus;
+    rt.tx_timeouts=txTimeouts;
+    if (rt.tx_timeouts >= TIMEOUT_OFFLINE && rt.state == ST_RUNNING){
+        rt.state=ST_OFFLINE;
+    }
+    return rt;
+}
+#endif
+// This will be called on Open() before any other initialization. Inherit this, if buffers can be set for the driver
+// and you want to change size of library send frame buffer size. See e.g. NMEA2000_teensy.cpp.
+void Nmea2kTwai::InitCANFrameBuffers()
+{
+    if (disabled){
+        logDebug(LOG_INFO,"twai init - disabled");
+    }
+    else{
+        initDriver();
+    }
+    tNMEA2000::InitCANFrameBuffers();
+    
+}
 bool Nmea2kTwai::checkRecovery(){
     if (disabled) return false;
     Status canState=getStatus();
@@ -182,10 +394,7 @@ Nmea2kTwai::Status Nmea2kTwai::logStatus(){
 bool Nmea2kTwai::startRecovery(){
     if (disabled) return false;
     lastRecoveryStart=millis();
-    esp_err_t rt=twai_driver_uninstall();
-    if (rt != ESP_OK){
-        logDebug(LOG_ERR,"twai: deinit for recovery failed with %x",(int)rt);
-    }
+    deinitDriver();
     initDriver();
     bool frt=CANOpen();
     return frt;
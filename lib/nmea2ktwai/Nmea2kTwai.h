@@ -2,6 +2,15 @@
 #define _NMEA2KTWAI_H
 #include "NMEA2000.h"
 #include "GwTimer.h"
+#ifdef GW_N2K_SOCKETCAN
+// host build on top of linux SocketCAN
+// GW_N2K_SOCKETCAN must be set to the interface name, e.g. -DGW_N2K_SOCKETCAN=\"vcan0\"
+// the pins are ignored in this mode
+#ifndef GPIO_NUM_NC
+typedef int gpio_num_t;
+#define GPIO_NUM_NC ((gpio_num_t)-1)
+#endif
+#endif
 
 class Nmea2kTwai : public tNMEA2000{
     public:
@@ -45,10 +54,12 @@ class Nmea2kTwai : public tNMEA2000{
     // and you want to change size of library send frame buffer size. See e.g. NMEA2000_teensy.cpp.
     virtual void InitCANFrameBuffers();
     virtual void logDebug(int level,const char *fmt,...){}
+    virtual bool isLogActive(int level){return false;}
     
 
     private:
     void initDriver();
+    void deinitDriver();
     bool startRecovery();
     bool checkRecovery();
     Status logStatus(); 
@@ -58,6 +69,11 @@ class Nmea2kTwai : public tNMEA2000{
     GwIntervalRunner timers;
     bool disabled=false;
     unsigned long lastRecoveryStart=0;
+#ifdef GW_N2K_SOCKETCAN
+    int canSocket=-1;
+    Status socketStatus;
+    void handleErrorFrame(unsigned long id, unsigned char len, const unsigned char *buf);
+#endif
 };
 
 #endif
\ No newline at end of file
@@ -65,22 +65,21 @@ FormattedData formatValue(GwApi::BoatValue *value, CommonData &commondata, bool
 
     result.cvalue = value->value;
 
-    // Load configuration values
-    String stimeZone = commondata.config->getString(commondata.config->timeZone);               // [UTC -14.00...+12.00]
-    double timeZone = stimeZone.toDouble();
-    String lengthFormat = commondata.config->getString(commondata.config->lengthFormat);        // [m|ft]
-    String distanceFormat = commondata.config->getString(commondata.config->distanceFormat);    // [m|km|nm]
-    String speedFormat = commondata.config->getString(commondata.config->speedFormat);          // [m/s|km/h|kn]
-    String windspeedFormat = commondata.config->getString(commondata.config->windspeedFormat);  // [m/s|km/h|kn|bft]
-    String tempFormat = commondata.config->getString(commondata.config->tempFormat);            // [K|°C|°F]
-    String dateFormat = commondata.config->getString(commondata.config->dateFormat);            // [DE|GB|US]
-    String precision = commondata.config->getString(commondata.config->valueprecision);         // [1|2]
+    // Load configuration values, typed handles avoid the name lookup
+    double timeZone = commondata.config->get(GwConfigHandles::timeZone);                      // [UTC -14.00...+12.00]
+    String lengthFormat = commondata.config->get(GwConfigHandles::lengthFormat);               // [m|ft]
+    String distanceFormat = commondata.config->get(GwConfigHandles::distanceFormat);           // [m|km|nm]
+    String speedFormat = commondata.config->get(GwConfigHandles::speedFormat);                 // [m/s|km/h|kn]
+    String windspeedFormat = commondata.config->get(GwConfigHandles::windspeedFormat);         // [m/s|km/h|kn|bft]
+    String tempFormat = commondata.config->get(GwConfigHandles::tempFormat);                   // [K|°C|°F]
+    String dateFormat = commondata.config->get(GwConfigHandles::dateFormat);                   // [DE|GB|US]
+    String precision = commondata.config->get(GwConfigHandles::valueprecision);                // [1|2]
 
     bool usesimudata;
     if (ignoreSimuDataSetting){
         usesimudata = false; // ignore user setting for simulation data; we want to format the boat value passed to this function
     } else {
-        usesimudata = commondata.config->getBool(commondata.config->useSimuData);              // [on|off]
+        usesimudata = commondata.config->get(GwConfigHandles::useSimuData);                     // [on|off]
     }
 
     // If boat value not valid
@@ -105,6 +105,30 @@ size_t GwBuffer::fetchData(int maxLen, GwBufferHandleFunction handler, void *par
     lp("fetchR",handled);
     return handled;
 }
+size_t GwBuffer::fetchDataV(GwBufferHandleFunctionV handler, void *param){
+    lp("fetchVE");
+    if (usedSpace() < 1) {
+        lp("fetchVR0",0);
+        return 0;
+    }
+    uint8_t *buffer2=nullptr;
+    size_t len1=0;
+    size_t len2=0;
+    if (writePointer > readPointer){
+        len1=writePointer-readPointer;
+    }
+    else{
+        len1=bufferSize-offset(readPointer);
+        len2=offset(writePointer);
+        if (len2 > 0) buffer2=buffer;
+    }
+    size_t handled=handler(readPointer,len1,buffer2,len2,param);
+    if (handled > (len1+len2)) handled=len1+len2;
+    readPointer+=handled;
+    if (offset(readPointer) >= bufferSize ) readPointer-=bufferSize;
+    lp("fetchVR",handled);
+    return handled;
+}
 size_t GwBuffer::fillData(int maxLen, GwBufferHandleFunction handler, void *param)
 {
     lp("fillDataE",maxLen);
@@ -154,12 +178,14 @@ size_t GwMessageFetcher::fetchMessageToBuffer(GwBuffer *gwbuffer,uint8_t *buffer
     int offset=gwbuffer->findChar(delimiter);
     if (offset <0) {
         if (! gwbuffer->freeSpace()){
+            overflows++;
             gwbuffer->reset(F("Message to long for input buffer"));
         }
         return 0;
     }
     offset+=1; //we include the delimiter
     if (offset >= bufferLen){
+        overflows++;
         gwbuffer->reset(F("Message to long for message buffer"));
         return 0;
     }
@@ -9,6 +9,7 @@ class GwBuffer;
 class GwMessageFetcher{
     public:
         int id=0;
+        unsigned long overflows=0; //messages dropped as they did not fit into the buffers
         virtual bool handleBuffer(GwBuffer *buffer)=0;
         virtual size_t fetchMessageToBuffer(GwBuffer *gwbuffer,uint8_t *buffer, size_t bufferLen,char delimiter);  
 };
@@ -21,6 +22,8 @@ class GwMessageFetcher{
 class GwBuffer{
     public:
         using GwBufferHandleFunction=std::function<size_t(uint8_t *buffer, size_t len, void *param)>;
+        //handler for both segments of the used space, buffer2 is nullptr if the data does not wrap around
+        using GwBufferHandleFunctionV=std::function<size_t(uint8_t *buffer1, size_t len1, uint8_t *buffer2, size_t len2, void *param)>;
         static const size_t TX_BUFFER_SIZE=1620; // app. 20 NMEA messages
         static const size_t RX_BUFFER_SIZE=600;  // enough for 1 NMEA message or actisense message or seasmart message
         typedef enum {
@@ -50,6 +53,11 @@ class GwBuffer{
         int read();
         int peek();
         size_t fetchData(int maxLen,GwBufferHandleFunction handler, void *param);
+        /**
+         * fetch all data in one call
+         * the handler gets both segments of the ring
+         */
+        size_t fetchDataV(GwBufferHandleFunctionV handler, void *param);
         /**
          * find the first occurance of x in the buffer, -1 if not found
          */
@@ -65,7 +65,8 @@ void GwRequestMessage::processImpl(){
       GW_MESSAGE_DEBUG("RequestMessage processImpl(1) %p\n",this);
       processRequest();
       GW_MESSAGE_DEBUG("RequestMessage processImpl(2) %p\n",this);
-      len=strlen(result.c_str());
+      if (binary) len=binaryResult.size();
+      else len=strlen(result.c_str());
       consumed=0;
       handled=true;
     }
@@ -80,7 +81,8 @@ int GwRequestMessage::consume(uint8_t *destination,int maxLen){
       if (consumed >= len) return 0;
       int cplen=maxLen;
       if (cplen > (len-consumed)) cplen=len-consumed;
-      memcpy(destination,result.c_str()+consumed,cplen);
+      const uint8_t *src=binary?binaryResult.data():(const uint8_t *)result.c_str();
+      memcpy(destination,src+consumed,cplen);
       consumed+=cplen;
       return cplen; 
     }
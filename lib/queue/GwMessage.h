@@ -2,6 +2,7 @@
 #define _GWMESSAGE_H
 #include <Arduino.h>
 #include <ESPAsyncWebServer.h>
+#include <vector>
 #include "GwLog.h"
 #include "esp_task_wdt.h"
 
@@ -38,6 +39,9 @@ class GwMessage{
 class GwRequestMessage : public GwMessage{
   protected:
     String result;
+    //binary responses fill this instead of result and set binary
+    std::vector<uint8_t> binaryResult;
+    bool binary=false;
     String contentType;
   private:  
     int len=0;
@@ -53,6 +57,8 @@ class GwRequestMessage : public GwMessage{
     int getLen(){return len;}
     int consume(uint8_t *destination,int maxLen);
     bool isHandled(){return handled;}
+    bool isBinary(){return binary;}
+    const std::vector<uint8_t> &getBinary(){return binaryResult;}
     String getContentType(){
       return contentType;
     }
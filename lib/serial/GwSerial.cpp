@@ -101,10 +101,45 @@ size_t GwSerial::sendToClients(const char *buf,int sourceId,bool partial){
     }
     return enqueued;
 }
+void GwSerial::receiveError(int err){
+    switch(err){
+        case UART_FIFO_OVF_ERROR:
+            fifoOverruns++;
+            break;
+        case UART_BUFFER_FULL_ERROR:
+            bufferFull++;
+            break;
+        case UART_FRAME_ERROR:
+            framingErrors++;
+            break;
+        case UART_PARITY_ERROR:
+            parityErrors++;
+            break;
+        default:
+            break;
+    }
+}
+void GwSerial::updateRate(unsigned long now){
+    if (windowStart == 0){
+        windowStart=now;
+        return;
+    }
+    unsigned long diff=now-windowStart;
+    if (diff < 1000) return;
+    rxRate=(float)windowBytes*1000.0/(float)diff;
+    windowBytes=0;
+    windowStart=now;
+}
 void GwSerial::loop(bool handleRead,bool handleWrite){
     write();
     if (! isInitialized()) return;
     if (! handleRead) return;
+    updateRate(millis());
+    if (eventMode){
+        //nothing received since the last read
+        if (! rxPending) return;
+        rxPending=false;
+    }
     size_t available=stream->available();
     if (! available) return;
     if (allowRead){
@@ -113,7 +148,11 @@ void GwSerial::loop(bool handleRead,bool handleWrite){
         },this);
         if (rd != 0){
             LOG_DEBUG(GwLog::DEBUG+2,"GwSerial %d read %d bytes",id,rd);
+            rxBytes+=rd;
+            windowBytes+=rd;
         }
+        //our buffer is full or the data wraps around - retry next loop
+        if (rd < available) rxPending=true;
     }
     else{
         uint8_t buffer[10];
@@ -144,6 +183,22 @@ bool GwSerial::flush(){
    availableWrite=(availableForWrite() > 0);
    return false;
 }
+int GwSerial::getJsonSize(){
+    if (! allowRead) return 0;
+    return JSON_OBJECT_SIZE(8);
+}
+void GwSerial::toJson(JsonObject &jo){
+    if (! allowRead) return;
+    JsonObject js=jo.createNestedObject("uart");
+    js["eventMode"]=eventMode;
+    js["events"]=rxEvents;
+    js["bytes"]=rxBytes;
+    js["bytesPerS"]=rxRate;
+    js["fifoOverruns"]=fifoOverruns;
+    js["bufferFull"]=bufferFull;
+    js["framingErrors"]=framingErrors;
+    js["parityErrors"]=parityErrors;
+}
 Stream * GwSerial::getStream(bool partialWrite){
     return new GwSerialStream(this,partialWrite);
 }
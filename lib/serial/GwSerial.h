@@ -28,7 +28,34 @@ class GwSerial : public GwChannelInterface{
         virtual int availableForWrite()=0;
         int type=0;
         SemaphoreHandle_t lock=nullptr;
+        /**
+         * event mode: the UART driver collects the data
+         * and calls us on RX FIFO full or RX timeout (idle line)
+         * we only read in the main loop if we got such an event
+         */
+        bool eventMode=false;
+        volatile bool rxPending=false;
+        void receiveEvent(){
+            rxEvents++;
+            rxPending=true;
+        }
+        void receiveError(int err);
+        //receive statistics
+        volatile unsigned long rxEvents=0;
+        volatile unsigned long fifoOverruns=0;
+        volatile unsigned long bufferFull=0;
+        volatile unsigned long framingErrors=0;
+        volatile unsigned long parityErrors=0;
+        unsigned long rxBytes=0;
+        unsigned long windowStart=0;
+        unsigned long windowBytes=0;
+        float rxRate=0;
+        void updateRate(unsigned long now);
     public:
+        //RX timeout (idle line) in symbols for the event mode
+        static const int RX_IDLE_SYMBOLS=2;
+        //size of the driver receive buffer in event mode
+        static const size_t RX_DRIVER_BUFFER=1024;
         GwSerial(GwLog *logger,Stream *stream,int id,int type,bool allowRead=true);
         void enableWriteLock(){
             lock=xSemaphoreCreateMutex();
@@ -43,6 +70,8 @@ class GwSerial : public GwChannelInterface{
         bool getAvailableWrite(){return availableWrite;}
         virtual void begin(unsigned long baud, uint32_t config=SERIAL_8N1, int8_t rxPin=-1, int8_t txPin=-1)=0;
         virtual int getType() override;
+        virtual int getJsonSize() override;
+        virtual void toJson(JsonObject &jo) override;
     friend GwSerialStream;
 };
 
@@ -53,6 +82,9 @@ template<typename T>
         template<class C>
         void beginImpl(C *s,unsigned long baud, uint32_t config=SERIAL_8N1, int8_t rxPin=-1, int8_t txPin=-1){}
         void beginImpl(HardwareSerial *s,unsigned long baud, uint32_t config=SERIAL_8N1, int8_t rxPin=-1, int8_t txPin=-1){
+            #ifndef GWSERIAL_POLL
+            if (allowRead) s->setRxBufferSize(RX_DRIVER_BUFFER);
+            #endif
             s->begin(baud,config,rxPin,txPin);
         }
         template<class C>
@@ -60,9 +92,25 @@ template<typename T>
         void setError(HardwareSerial *s,GwLog *logger){
             LOG_DEBUG(GwLog::LOG,"enable serial errors for channel %d",id);
             s->onReceiveError([logger,this](hardwareSerial_error_t err){
+                this->receiveError((int)err);
                 LOG_DEBUG(GwLog::ERROR,"serial error on id %d: %d",this->id,(int)err);
             });
         }
+        template<class C>
+        void setEvents(C* s, GwLog *logger){}
+        void setEvents(HardwareSerial *s,GwLog *logger){
+            #ifndef GWSERIAL_POLL
+            if (! allowRead) return;
+            LOG_DEBUG(GwLog::LOG,"enable serial receive events for channel %d",id);
+            s->setRxTimeout(RX_IDLE_SYMBOLS);
+            s->onReceive([this](){
+                this->receiveEvent();
+            },false);
+            //data that arrived before
+            rxPending=true;
+            eventMode=true;
+            #endif
+        }
         #if CONFIG_IDF_TARGET_ESP32C3 || CONFIG_IDF_TARGET_ESP32S3
             void beginImpl(HWCDC *s,unsigned long baud, uint32_t config=SERIAL_8N1, int8_t rxPin=-1, int8_t txPin=-1){
             s->begin(baud);
@@ -120,6 +168,7 @@ template<typename T>
         virtual void begin(unsigned long baud, uint32_t config=SERIAL_8N1, int8_t rxPin=-1, int8_t txPin=-1) override{
             beginImpl(serial,baud,config,rxPin,txPin);
             setError(serial,logger);
+            setEvents(serial,logger);
         };
 
 
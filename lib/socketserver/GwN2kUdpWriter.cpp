@@ -0,0 +1,115 @@
+#include "GwN2kUdpWriter.h"
+#include <errno.h>
+
+GwN2kUdpWriter::GwN2kUdpWriter(const GwConfigHandler *config, GwLog *logger, int minId)
+{
+    this->config = config;
+    this->logger = logger;
+    this->minId = minId;
+    port=config->getInt(GwConfigDefinitions::n2kuPort);
+    format=(Format)config->getInt(GwConfigDefinitions::n2kuFormat);
+    int ft=config->getInt(GwConfigDefinitions::n2kuFlush);
+    flushTime=ft > 0?ft:0;
+}
+
+void GwN2kUdpWriter::begin()
+{
+    if (fd >= 0) return; //already started
+    String dst=config->getString(GwConfigDefinitions::n2kuAddress);
+    LOG_INFO("N2KU begin, dst=%s:%d, format=%d, flush=%lums",dst.c_str(),port,(int)format,flushTime);
+    if (inet_pton(AF_INET, dst.c_str(), &dstA.sin_addr) != 1)
+    {
+        LOG_ERROR("N2KU: invalid destination ip address %s", dst.c_str());
+        return;
+    }
+    dstA.sin_family=AF_INET;
+    dstA.sin_port=htons(port);
+    fd=socket(AF_INET,SOCK_DGRAM,IPPROTO_IP);
+    if (fd < 0){
+        LOG_ERROR("N2KU: unable to create udp socket: %d",errno);
+        return;
+    }
+    int enable = 1;
+    setsockopt(fd, SOL_SOCKET, SO_BROADCAST, &enable, sizeof(int));
+    datagram=new uint8_t[MAX_DATAGRAM];
+    fill=0;
+}
+
+bool GwN2kUdpWriter::sendDatagram(const uint8_t *data, size_t len){
+    if (fd < 0 || len == 0) return false;
+    ssize_t err = sendto(fd,data,len,0,(struct sockaddr *)&dstA, sizeof(dstA));
+    if (err < 0){
+        numErrors++;
+        LOG_DEBUG(GwLog::DEBUG,"N2KU error sending: %d", errno);
+        return false;
+    }
+    numDatagrams++;
+    numBytes+=len;
+    return true;
+}
+
+void GwN2kUdpWriter::flush(){
+    if (fill == 0) return;
+    sendDatagram(datagram,fill);
+    fill=0;
+}
+
+void GwN2kUdpWriter::add(const uint8_t *data, size_t len){
+    if ((fill + len) > MAX_DATAGRAM){
+        flush();
+    }
+    if (len > MAX_DATAGRAM) len=MAX_DATAGRAM;
+    if (fill == 0) firstMessage=millis();
+    memcpy(datagram+fill,data,len);
+    fill+=len;
+}
+
+void GwN2kUdpWriter::loop(bool handleRead, bool handleWrite)
+{
+    if (! handleWrite || fill == 0) return;
+    if ((millis() - firstMessage) >= flushTime){
+        flush();
+    }
+}
+
+void GwN2kUdpWriter::readMessages(GwMessageFetcher *writer)
+{
+}
+
+size_t GwN2kUdpWriter::sendToClients(const char *buf, int source,bool partial)
+{
+    //no NMEA0183
+    return 0;
+}
+
+size_t GwN2kUdpWriter::sendN2k(GwN2kEncodings &encodings, int sourceId){
+    if (fd < 0 || sourceId == minId) return 0;
+    size_t len=0;
+    const uint8_t *data=encodings.get(
+        (format == F_BINARY)?GwN2kEncodings::BINARY:GwN2kEncodings::YDRAW,
+        len);
+    if (data == nullptr || len == 0) return 0;
+    numMessages++;
+    if (len > MAX_DATAGRAM){
+        //a large fast packet in YD RAW - split at the frame lines
+        //so that no datagram gets fragmented
+        size_t start=0;
+        for (size_t i=0;i<len;i++){
+            if (data[i] != '\n') continue;
+            add(data+start,i+1-start);
+            start=i+1;
+        }
+        if (start < len) add(data+start,len-start);
+    }
+    else{
+        add(data,len);
+    }
+    if (flushTime == 0) flush();
+    return len;
+}
+
+GwN2kUdpWriter::~GwN2kUdpWriter()
+{
+    if (fd >= 0) ::close(fd);
+    delete[] datagram;
+}
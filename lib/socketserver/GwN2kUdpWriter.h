@@ -0,0 +1,59 @@
+#ifndef _GWN2KUDPWRITER_H
+#define _GWN2KUDPWRITER_H
+#include "GWConfig.h"
+#include "GwLog.h"
+#include "GwBuffer.h"
+#include "GwChannelInterface.h"
+#include "GwN2kEncodings.h"
+#include <sys/socket.h>
+#include <arpa/inet.h>
+
+/**
+ * send NMEA2000 messages via UDP
+ * either as YD RAW text or in the compact binary format (see GwN2kEncodings)
+ * messages are collected into one datagram until the next one would exceed
+ * MAX_DATAGRAM (below the WiFi MTU) or the flush time since the first message
+ * in the datagram has elapsed
+ * YD RAW fast packets longer than MAX_DATAGRAM are split at the frame lines
+ */
+class GwN2kUdpWriter: public GwChannelInterface{
+    public:
+    using Format=enum{
+        F_YDRAW=0,
+        F_BINARY=1
+    };
+    static const size_t MAX_DATAGRAM=1400;
+    private:
+        const GwConfigHandler *config;
+        GwLog *logger;
+        int minId;
+        int port;
+        int fd=-1;
+        struct sockaddr_in dstA;
+        Format format=F_YDRAW;
+        unsigned long flushTime=20;
+        uint8_t *datagram=nullptr;
+        size_t fill=0;
+        unsigned long firstMessage=0;
+        unsigned long numMessages=0;
+        unsigned long numDatagrams=0;
+        unsigned long numBytes=0;
+        unsigned long numErrors=0;
+        bool sendDatagram(const uint8_t *data,size_t len);
+        void flush();
+        //append to the datagram, send it before it would exceed MAX_DATAGRAM
+        void add(const uint8_t *data,size_t len);
+    public:
+        GwN2kUdpWriter(const GwConfigHandler *config,GwLog *logger,int minId);
+        ~GwN2kUdpWriter();
+        void begin();
+        virtual void loop(bool handleRead=true,bool handleWrite=true);
+        virtual size_t sendToClients(const char *buf,int sourceId, bool partialWrite=false);
+        virtual void readMessages(GwMessageFetcher *writer);
+        virtual size_t sendN2k(GwN2kEncodings &encodings, int sourceId);
+        unsigned long getMessages(){ return numMessages;}
+        unsigned long getDatagrams(){ return numDatagrams;}
+        unsigned long getBytes(){ return numBytes;}
+        unsigned long getErrors(){ return numErrors;}
+};
+#endif
@@ -28,9 +28,12 @@ void GwSocketConnection::setClient(int fd)
     if (readBuffer)
         readBuffer->reset("new client");
     overflows = 0;
-    pendingWrite = false;
     writeError = false;
-    lastWrite = 0;
+    lastProgress = millis();
+    numLatest = 0;
+    dropsLowPrio = 0;
+    coalesced = 0;
+    maxStall = 0;
     if (fd >= 0)
     {
         remoteIpAddress = remoteIP(fd).toString();
@@ -57,12 +60,15 @@ GwSocketConnection::~GwSocketConnection()
     delete buffer;
     if (readBuffer)
         delete readBuffer;
+    if (latest)
+        delete[] latest;
 }
 bool GwSocketConnection::connected()
 {
     if (fd >= 0)
     {
         uint8_t dummy;
+        GwSocketReadiness::countCall();
         int res = recv(fd, &dummy, 0, MSG_DONTWAIT);
         // avoid unused var warning by gcc
         (void)res;
@@ -94,10 +100,170 @@ bool GwSocketConnection::connected()
     return false;
 }
 
+static bool isSeaSmart(const uint8_t *data, size_t len)
+{
+    return len > 13 && strncmp((const char *)data, "$PCDIN,", 7) == 0;
+}
+static unsigned long seaSmartPgn(const uint8_t *data)
+{
+    char hex[7];
+    memcpy(hex, data + 7, 6);
+    hex[6] = 0;
+    return strtoul(hex, NULL, 16);
+}
+/**
+ * messages that are dropped first and never coalesced
+ * AIS (0183 and seasmart): one sentence per target
+ * XDR: different transducers with the same type
+ * multi sentence groups: we cannot keep only one part
+ */
+static bool isLowPriority(const uint8_t *data, size_t len)
+{
+    if (len < 6)
+        return false;
+    if (data[0] == '!')
+        return true; //AIS
+    if (data[0] != '$')
+        return false;
+    if (isSeaSmart(data, len))
+    {
+        unsigned long pgn = seaSmartPgn(data);
+        return (pgn >= 129038 && pgn <= 129041) || (pgn >= 129793 && pgn <= 129810);
+    }
+    const char *type = (const char *)data + 3;
+    static const char *dropTypes[] = {"XDR", "GSV", "RTE", "WPL", "TXT"};
+    for (size_t i = 0; i < sizeof(dropTypes) / sizeof(dropTypes[0]); i++)
+    {
+        if (strncmp(type, dropTypes[i], 3) == 0)
+            return true;
+    }
+    return false;
+}
+/**
+ * copy field number "field" (0: sentence id) to key
+ */
+static size_t addField(const uint8_t *data, size_t len, int field, char *key, size_t k, size_t keyLen)
+{
+    size_t i = 0;
+    for (; i < len && field > 0; i++)
+    {
+        if (data[i] == ',')
+            field--;
+    }
+    for (; i < len && k < (keyLen - 1) && data[i] != ',' && data[i] != '*'; i++)
+    {
+        key[k++] = data[i];
+    }
+    return k;
+}
+/**
+ * the key for coalescing
+ * sentence type without talker, for MWV including the reference (R/T)
+ * for seasmart the PGN and the N2K source
+ */
+static void sentenceKey(const uint8_t *data, size_t len, char *key, size_t keyLen)
+{
+    size_t k = 0;
+    if (isSeaSmart(data, len))
+    {
+        k = addField(data, len, 1, key, k, keyLen);
+        if (k < (keyLen - 1))
+            key[k++] = ',';
+        k = addField(data, len, 3, key, k, keyLen);
+    }
+    else if (len > 6 && data[0] == '$')
+    {
+        k = addField(data + 3, len - 3, 0, key, k, keyLen);
+        if (strncmp((const char *)data + 3, "MWV", 3) == 0)
+        {
+            if (k < (keyLen - 1))
+                key[k++] = ',';
+            k = addField(data, len, 2, key, k, keyLen);
+        }
+    }
+    else
+    {
+        k = addField(data, len, 0, key, k, keyLen);
+    }
+    key[k] = 0;
+}
+bool GwSocketConnection::storeLatest(const uint8_t *data, size_t len)
+{
+    if (len > MAX_LATEST_LEN)
+        return false;
+    if (!latest)
+        latest = new Latest[MAX_LATEST];
+    char key[MAX_KEY_LEN];
+    sentenceKey(data, len, key, MAX_KEY_LEN);
+    Latest *entry = NULL;
+    for (int i = 0; i < numLatest; i++)
+    {
+        if (strcmp(latest[i].key, key) == 0)
+        {
+            entry = &latest[i];
+            coalesced++;
+            break;
+        }
+    }
+    if (!entry)
+    {
+        if (numLatest >= MAX_LATEST)
+            return false;
+        entry = &latest[numLatest];
+        numLatest++;
+        strcpy(entry->key, key);
+    }
+    memcpy(entry->data, data, len);
+    entry->len = len;
+    return true;
+}
+void GwSocketConnection::flushLatest()
+{
+    if (numLatest == 0)
+        return;
+    if (buffer->usedSpace() >= HIGH_WATER)
+        return;
+    int done = 0;
+    while (done < numLatest && buffer->freeSpace() >= latest[done].len)
+    {
+        buffer->addData(latest[done].data, latest[done].len);
+        done++;
+    }
+    if (done == 0)
+        return;
+    for (int i = done; i < numLatest; i++)
+    {
+        latest[i - done] = latest[i];
+    }
+    numLatest -= done;
+}
+
 bool GwSocketConnection::enqueue(uint8_t *data, size_t len)
 {
     if (len == 0)
         return true;
+    size_t used = buffer->usedSpace();
+    bool lowPriority = isLowPriority(data, len);
+    if ((used >= HIGH_WATER || numLatest > 0) && lowPriority)
+    {
+        dropsLowPrio++;
+        return false;
+    }
+    if (buffer->freeSpace() < len && hasClient())
+    {
+        //normally we write once per loop
+        //only write out now if the data would not fit any more
+        write();
+        used = buffer->usedSpace();
+    }
+    if (!lowPriority && len <= MAX_LATEST_LEN && (numLatest > 0 || (used + len) > COALESCE_WATER))
+    {
+        if (storeLatest(data, len))
+            return true;
+        LOG_DEBUG(GwLog::LOG, "overflow on %s", remoteIpAddress.c_str());
+        overflows++;
+        return false;
+    }
     size_t rt = buffer->addData(data, len);
     if (rt < len)
     {
@@ -138,43 +304,47 @@ GwBuffer::WriteStatus GwSocketConnection::write()
         LOG_DEBUG(GwLog::LOG, "write called on empty client");
         return GwBuffer::ERROR;
     }
-    if (!buffer->usedSpace())
+    if (!buffer->usedSpace() && numLatest == 0)
     {
-        pendingWrite = false;
+        lastProgress = millis();
         return GwBuffer::OK;
     }
-    buffer->fetchData(
-        -1, [](uint8_t *buffer, size_t len, void *param) -> size_t
+    //send both segments of the ring with one call
+    buffer->fetchDataV(
+        [](uint8_t *buffer1, size_t len1, uint8_t *buffer2, size_t len2, void *param) -> size_t
         {
             GwSocketConnection *c = (GwSocketConnection *)param;
-            int res = send(c->fd, (void *)buffer, len, MSG_DONTWAIT);
+            struct iovec iov[2];
+            iov[0].iov_base = buffer1;
+            iov[0].iov_len = len1;
+            iov[1].iov_base = buffer2;
+            iov[1].iov_len = len2;
+            struct msghdr msg;
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_iov = iov;
+            msg.msg_iovlen = (buffer2 != nullptr) ? 2 : 1;
+            GwSocketReadiness::countCall();
+            int res = sendmsg(c->fd, &msg, MSG_DONTWAIT);
             if (!c->handleError(res, false))
                 return 0;
-            if (res >= len)
-            {
-                c->pendingWrite = false;
-            }
-            else
+            if (res > 0)
             {
-                if (!c->pendingWrite)
-                {
-                    c->lastWrite = millis();
-                    c->pendingWrite = true;
-                }
-                else
-                {
-                    //we need to check if we have still not been able
-                    //to write until timeout
-                    if (millis() >= (c->lastWrite + c->writeTimeout))
-                    {
-                        c->logger->logDebug(GwLog::ERROR, "Write timeout on channel %s", c->remoteIpAddress.c_str());
-                        c->writeError = true;
-                    }
-                }
+                c->numSends++;
+                c->sentBytes += res;
+                c->lastProgress = millis();
             }
             return res;
         },
         this);
+    flushLatest();
+    unsigned long stall = getStallTime();
+    if (stall > maxStall)
+        maxStall = stall;
+    if (stall >= writeTimeout)
+    {
+        LOG_DEBUG(GwLog::ERROR, "Write timeout on channel %s", remoteIpAddress.c_str());
+        writeError = true;
+    }
     if (writeError)
     {
         LOG_DEBUG(GwLog::DEBUG + 1, "write error on %s", remoteIpAddress.c_str());
@@ -183,6 +353,27 @@ GwBuffer::WriteStatus GwSocketConnection::write()
 
     return GwBuffer::OK;
 }
+unsigned long GwSocketConnection::getStallTime()
+{
+    if (!hasClient() || (buffer->usedSpace() == 0 && numLatest == 0))
+        return 0;
+    return millis() - lastProgress;
+}
+int GwSocketConnection::getJsonSize()
+{
+    return JSON_OBJECT_SIZE(8);
+}
+void GwSocketConnection::toJson(JsonObject &jo)
+{
+    jo["ip"] = remoteIpAddress;
+    jo["queued"] = buffer->usedSpace();
+    jo["coalescing"] = numLatest;
+    jo["dropLowPrio"] = dropsLowPrio;
+    jo["coalesced"] = coalesced;
+    jo["dropFull"] = overflows;
+    jo["stall"] = getStallTime();
+    jo["maxStall"] = maxStall;
+}
 
 bool GwSocketConnection::read()
 {
@@ -190,6 +381,7 @@ bool GwSocketConnection::read()
     {
         size_t maxLen = 100;
         char buffer[maxLen];
+        GwSocketReadiness::countCall();
         int res = recv(fd, (void *)buffer, maxLen, MSG_DONTWAIT);
         return handleError(res);
     }
@@ -197,6 +389,7 @@ bool GwSocketConnection::read()
         -1, [](uint8_t *buffer, size_t len, void *param) -> size_t
         {
             GwSocketConnection *c = (GwSocketConnection *)param;
+            GwSocketReadiness::countCall();
             int res = recv(c->fd, (void *)buffer, len, MSG_DONTWAIT);
             if (!c->handleError(res))
                 return 0;
@@ -2,19 +2,51 @@
 #include <Arduino.h>
 #include <lwip/sockets.h>
 #include "GwBuffer.h"
+#include "GwSocketReadiness.h"
 class GwSocketConnection
 {
 public:
     int fd=-1;
     int overflows;
     String remoteIpAddress;
+    /**
+     * backpressure for slow clients
+     * above HIGH_WATER we drop AIS, XDR and multi sentence groups (GSV, RTE, WPL, TXT)
+     * above COALESCE_WATER we only keep the latest sentence per type
+     * (per reference for MWV, per PGN and N2K source for seasmart)
+     * longer messages (seasmart for fast packets) are not coalesced,
+     * they are still queued directly as long as they fit
+     * until the buffer drains below HIGH_WATER again
+     * if we cannot write anything for writeTimeout we disconnect
+     */
+    static const size_t HIGH_WATER = GwBuffer::TX_BUFFER_SIZE / 2;
+    static const size_t COALESCE_WATER = (GwBuffer::TX_BUFFER_SIZE * 3) / 4;
+    static const int MAX_LATEST = 12;
+    static const size_t MAX_LATEST_LEN = 100;
+    static const size_t MAX_KEY_LEN = 14;
 
 private:
-    unsigned long lastWrite = 0;
+    class Latest
+    {
+    public:
+        char key[MAX_KEY_LEN];
+        uint8_t data[MAX_LATEST_LEN];
+        size_t len = 0;
+    };
+    Latest *latest = NULL;
+    int numLatest = 0;
+    unsigned long lastProgress = 0;
     unsigned long writeTimeout = 10000;
-    bool pendingWrite = false;
     bool writeError = false;
     bool allowRead;
+    //statistics
+    unsigned long numSends = 0;
+    unsigned long sentBytes = 0;
+    unsigned long dropsLowPrio = 0;
+    unsigned long coalesced = 0;
+    unsigned long maxStall = 0;
+    bool storeLatest(const uint8_t *data, size_t len);
+    void flushLatest();
     GwBuffer *buffer = NULL;
     GwBuffer *readBuffer = NULL;
     GwLog *logger;
@@ -33,4 +65,10 @@ public:
     GwBuffer::WriteStatus write();
     bool read();
     bool messagesFromBuffer(GwMessageFetcher *writer);
+    unsigned long getNumSends(){ return numSends;}
+    unsigned long getSentBytes(){ return sentBytes;}
+    //time (ms) we could not write anything while having data
+    unsigned long getStallTime();
+    int getJsonSize();
+    void toJson(JsonObject &jo);
 };
@@ -0,0 +1,70 @@
+#include "GwSocketReadiness.h"
+
+unsigned long GwSocketReadiness::numCalls=0;
+unsigned long GwSocketReadiness::numSelects=0;
+
+GwSocketReadiness::GwSocketReadiness(){
+    reset();
+}
+void GwSocketReadiness::reset(){
+    FD_ZERO(&readSet);
+    FD_ZERO(&writeSet);
+    maxFd=-1;
+    selected=false;
+}
+void GwSocketReadiness::addRead(int fd){
+    if (fd < 0) return;
+    FD_SET(fd,&readSet);
+    if (fd > maxFd) maxFd=fd;
+}
+void GwSocketReadiness::addWrite(int fd){
+    if (fd < 0) return;
+    FD_SET(fd,&writeSet);
+    if (fd > maxFd) maxFd=fd;
+}
+void GwSocketReadiness::select(){
+#ifndef GW_NO_SOCKET_SELECT
+    if (maxFd < 0) return;
+    readyRead=readSet;
+    readyWrite=writeSet;
+    struct timeval tv;
+    tv.tv_sec=0;
+    tv.tv_usec=0;
+    numSelects++;
+    countCall();
+    int res=::select(maxFd+1,&readyRead,&readyWrite,nullptr,&tv);
+    if (res < 0){
+        //fall back to polling in this loop
+        selectErrors++;
+        return;
+    }
+    selected=true;
+#endif
+}
+bool GwSocketReadiness::canRead(int fd){
+    if (! selected || fd < 0) return true;
+    if (! FD_ISSET(fd,&readSet)) return true;
+    return FD_ISSET(fd,&readyRead);
+}
+bool GwSocketReadiness::canWrite(int fd){
+    if (! selected || fd < 0) return true;
+    if (! FD_ISSET(fd,&writeSet)) return true;
+    return FD_ISSET(fd,&readyWrite);
+}
+int GwSocketReadiness::getJsonSize(){
+    return JSON_OBJECT_SIZE(4);
+}
+void GwSocketReadiness::toJson(GwJsonDocument &doc){
+    unsigned long now=millis();
+    if (windowStart == 0 || (now-windowStart) >= 1000){
+        if (windowStart != 0){
+            callRate=(float)(numCalls-windowCalls)*1000.0/(float)(now-windowStart);
+        }
+        windowStart=now;
+        windowCalls=numCalls;
+    }
+    doc["socketCalls"]=numCalls;
+    doc["socketCallsPerS"]=callRate;
+    doc["socketSelects"]=numSelects;
+    doc["socketSelectErrors"]=selectErrors;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <Arduino.h>
+#include <lwip/sockets.h>
+#include "GwJsonDocument.h"
+
+/**
+ * readiness for all gateway sockets
+ * the socket channels register their sockets, we do one select per loop
+ * and the channels only touch sockets that are ready
+ * build with -DGW_NO_SOCKET_SELECT to poll all sockets as before
+ * (for comparing the syscall counts)
+ */
+class GwSocketReadiness{
+    fd_set readSet;
+    fd_set writeSet;
+    fd_set readyRead;
+    fd_set readyWrite;
+    int maxFd=-1;
+    bool selected=false;
+    unsigned long selectErrors=0;
+    static unsigned long numCalls;
+    static unsigned long numSelects;
+    unsigned long windowStart=0;
+    unsigned long windowCalls=0;
+    float callRate=0;
+    public:
+        GwSocketReadiness();
+        void reset();
+        void addRead(int fd);
+        void addWrite(int fd);
+        /**
+         * check all registered sockets (no wait)
+         */
+        void select();
+        /**
+         * true if the last select succeeded
+         * false without select (GW_NO_SOCKET_SELECT) or after an error,
+         * the channels have to poll their sockets then
+         */
+        bool hasResult() const { return selected;}
+        /**
+         * sockets that have not been registered are always reported as ready
+         */
+        bool canRead(int fd);
+        bool canWrite(int fd);
+        //count a socket call (accept,recv,send,...)
+        static void countCall(){ numCalls++;}
+        int getJsonSize();
+        void toJson(GwJsonDocument &doc);
+};
@@ -4,6 +4,7 @@
 #include "GwBuffer.h"
 #include "GwSocketConnection.h"
 #include "GwSocketHelper.h"
+#include "GwSocketReadiness.h"
 
 GwSocketServer::GwSocketServer(const GwConfigHandler *config, GwLog *logger, int minId)
 {
@@ -37,6 +38,7 @@ void GwSocketServer::begin()
 {
     maxClients = config->getInt(config->maxClients);
     allowReceive = config->getBool(config->readTCP);
+    noDelay = ! config->getBool(config->tcpBatch);
     listenerPort=config->getInt(config->serverPort);
     clients = new GwSocketConnection*[maxClients];
     for (int i = 0; i < maxClients; i++)
@@ -59,11 +61,14 @@ int GwSocketServer::available()
     int client_sock;
     struct sockaddr_in _client;
     int cs = sizeof(struct sockaddr_in);
+    if (readiness && ! readiness->canRead(listener))
+        return -1;
+    GwSocketReadiness::countCall();
     client_sock = accept(listener, (struct sockaddr *)&_client, (socklen_t *)&cs);
     if (client_sock >= 0)
     {
         int val = 1;
-        if (! GwSocketHelper::setKeepAlive(client_sock,true)){
+        if (! GwSocketHelper::setKeepAlive(client_sock,noDelay)){
             LOG_DEBUG(GwLog::ERROR,"unable to set keepalive, nodelay on socket");
         }
         else
@@ -122,7 +127,13 @@ void GwSocketServer::loop(bool handleRead, bool handleWrite)
         GwSocketConnection *client = clients[i];
         if (!client->hasClient())
             continue;
-
+        if (readiness && readiness->hasResult())
+        {
+            //a closed connection becomes readable and read will detect this
+            if (handleRead && readiness->canRead(client->fd))
+                client->read();
+            continue;
+        }
         if (!client->connected())
         {
             LOG_DEBUG(GwLog::LOG, "client %d disconnect %s", i, client->remoteIpAddress.c_str());
@@ -163,10 +174,14 @@ size_t GwSocketServer::sendToClients(const char *buf, int source,bool partial)
         GwSocketConnection *client = clients[i];
         if (!client->hasClient())
             continue;
-        if (client->connected())
-        {
-            if(client->enqueue((uint8_t *)buf, len)) hasSend=true;
-        }
+#ifdef GW_NO_SOCKET_SELECT
+        //old polling: probe the connection for every message
+        if (!client->connected())
+            continue;
+#endif
+        //with select dead clients are detected by write errors
+        //and by the read after select reported them readable
+        if(client->enqueue((uint8_t *)buf, len)) hasSend=true;
     }
     return hasSend?len:0;
 }
@@ -183,6 +198,47 @@ int GwSocketServer::numClients()
     }
     return num;
 }
+void GwSocketServer::addFds(GwSocketReadiness *r){
+    if (listener >= 0) r->addRead(listener);
+    if (!clients)
+        return;
+    for (int i = 0; i < maxClients; i++)
+    {
+        if (clients[i]->hasClient())
+            r->addRead(clients[i]->fd);
+    }
+}
+int GwSocketServer::getJsonSize(){
+    int rt=JSON_OBJECT_SIZE(4)+JSON_ARRAY_SIZE(maxClients);
+    if (clients){
+        for (int i = 0; i < maxClients; i++){
+            if (clients[i]->hasClient()) rt+=clients[i]->getJsonSize();
+        }
+    }
+    return rt;
+}
+void GwSocketServer::toJson(JsonObject &jo){
+    unsigned long sends=0;
+    unsigned long bytes=0;
+    if (clients){
+        for (int i = 0; i < maxClients; i++){
+            sends+=clients[i]->getNumSends();
+            bytes+=clients[i]->getSentBytes();
+        }
+    }
+    JsonObject js=jo.createNestedObject("tx");
+    js["noDelay"]=noDelay;
+    js["sends"]=sends;
+    js["bytes"]=bytes;
+    js["bytesPerSend"]=sends?(float)bytes/(float)sends:0;
+    JsonArray jc=jo.createNestedArray("clients");
+    if (! clients) return;
+    for (int i = 0; i < maxClients; i++){
+        if (! clients[i]->hasClient()) continue;
+        JsonObject jcl=jc.createNestedObject();
+        clients[i]->toJson(jcl);
+    }
+}
 GwSocketServer::~GwSocketServer()
 {
 }
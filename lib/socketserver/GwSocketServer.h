@@ -7,6 +7,7 @@
 #include <memory>
 
 class GwSocketConnection;
+class GwSocketReadiness;
 class GwSocketServer: public GwChannelInterface{
     private:
         const GwConfigHandler *config;
@@ -15,8 +16,10 @@ class GwSocketServer: public GwChannelInterface{
         int listener=-1;
         int listenerPort=-1;
         bool allowReceive;
+        bool noDelay=true;
         int maxClients;
         int minId;
+        GwSocketReadiness *readiness=nullptr;
         bool createListener();
         int available();
     public:
@@ -26,6 +29,10 @@ class GwSocketServer: public GwChannelInterface{
         virtual void loop(bool handleRead=true,bool handleWrite=true);
         virtual size_t sendToClients(const char *buf,int sourceId, bool partialWrite=false);
         int numClients();
+        void setReadiness(GwSocketReadiness *r){ readiness=r;}
+        void addFds(GwSocketReadiness *r);
         virtual void readMessages(GwMessageFetcher *writer);
+        virtual int getJsonSize() override;
+        virtual void toJson(JsonObject &jo) override;
 };
 #endif
\ No newline at end of file
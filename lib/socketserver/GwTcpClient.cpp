@@ -73,7 +73,7 @@ void GwTcpClient::startConnection()
         LOG_DEBUG(GwLog::ERROR,"unable to create socket: %d", errno);
         return; 
     }
-    if (! GwSocketHelper::setKeepAlive(sockfd,true)){
+    if (! GwSocketHelper::setKeepAlive(sockfd,noDelay)){
         error="unable to set keepalive, nodelay on socket";
         LOG_DEBUG(GwLog::ERROR,"%s",error.c_str());
         close(sockfd);
@@ -187,9 +187,10 @@ GwTcpClient::~GwTcpClient(){
     delete connection;
     vSemaphoreDelete(locker);
 }
-void GwTcpClient::begin(int sourceId,String address, uint16_t port,bool allowRead)
+void GwTcpClient::begin(int sourceId,String address, uint16_t port,bool allowRead,bool noDelay)
 {
     stop();
+    this->noDelay=noDelay;
     this->sourceId=sourceId;
     this->remoteAddress = address;
     this->port = port;
@@ -205,7 +206,13 @@ void GwTcpClient::loop(bool handleRead,bool handleWrite)
         return;
     }
     if (handleRead){
-        if (connection->hasClient()){
+        if (readiness && readiness->hasResult()){
+            //a closed connection becomes readable and read will detect this
+            if (connection->hasClient() && readiness->canRead(connection->fd)){
+                connection->read();
+            }
+        }
+        else if (connection->hasClient()){
             if (! connection->connected()){
                 LOG_DEBUG(GwLog::ERROR,"tcp client connection closed on %s",connection->remoteIpAddress.c_str());
                 connection->stop();
@@ -292,3 +299,25 @@ GwTcpClient::ResolvedAddress GwTcpClient::getResolved(){
     GWSYNCHRONIZED(locker);
     return resolvedAddress;
 }
+void GwTcpClient::addFds(GwSocketReadiness *r){
+    if (state != C_CONNECTED || ! connection || ! connection->hasClient()) return;
+    r->addRead(connection->fd);
+}
+int GwTcpClient::getJsonSize(){
+    int rt=JSON_OBJECT_SIZE(4)+JSON_OBJECT_SIZE(1);
+    if (connection) rt+=connection->getJsonSize();
+    return rt;
+}
+void GwTcpClient::toJson(JsonObject &jo){
+    if (! connection) return;
+    unsigned long sends=connection->getNumSends();
+    unsigned long bytes=connection->getSentBytes();
+    JsonObject js=jo.createNestedObject("tx");
+    js["noDelay"]=noDelay;
+    js["sends"]=sends;
+    js["bytes"]=bytes;
+    js["bytesPerSend"]=sends?(float)bytes/(float)sends:0;
+    if (! connection->hasClient()) return;
+    JsonObject jc=jo.createNestedObject("connection");
+    connection->toJson(jc);
+}
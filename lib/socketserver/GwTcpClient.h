@@ -18,6 +18,8 @@ class GwTcpClient : public GwChannelInterface
     GwLog *logger;
     int sourceId;
     bool configured=false;
+    bool noDelay=true;
+    GwSocketReadiness *readiness=nullptr;
     String error;
     SemaphoreHandle_t locker;
 
@@ -47,10 +49,14 @@ private:
 public:
     GwTcpClient(GwLog *logger);
     ~GwTcpClient();
-    void begin(int sourceId,String address, uint16_t port,bool allowRead);
+    void begin(int sourceId,String address, uint16_t port,bool allowRead,bool noDelay=true);
     virtual void loop(bool handleRead=true,bool handleWrite=true);
     virtual size_t sendToClients(const char *buf,int sourceId, bool partialWrite=false);
     virtual void readMessages(GwMessageFetcher *writer);
     bool isConnected();
     String getError(){return error;}
+    void setReadiness(GwSocketReadiness *r){ readiness=r;}
+    void addFds(GwSocketReadiness *r);
+    virtual int getJsonSize() override;
+    virtual void toJson(JsonObject &jo) override;
 };
\ No newline at end of file
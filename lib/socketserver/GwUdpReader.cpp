@@ -5,6 +5,7 @@
 #include "GwSocketConnection.h"
 #include "GwSocketHelper.h"
 #include "GWWifi.h"
+#include <lwip/stats.h>
 
 GwUdpReader::GwUdpReader(const GwConfigHandler *config, GwLog *logger, int minId)
 {
@@ -12,7 +13,8 @@ GwUdpReader::GwUdpReader(const GwConfigHandler *config, GwLog *logger, int minId
     this->logger = logger;
     this->minId = minId;
     port=config->getInt(GwConfigDefinitions::udprPort);
-    buffer= new GwBuffer(logger,GwBuffer::RX_BUFFER_SIZE,"udprd");
+    buffer= new GwBuffer(logger,2*MAX_DATAGRAM+2,"udprd");
+    receiveBuffer=new uint8_t[MAX_DATAGRAM+2];
 }
 
 void GwUdpReader::createAndBind(){
@@ -139,21 +141,56 @@ void GwUdpReader::loop(bool handleRead, bool handleWrite)
 void GwUdpReader::readMessages(GwMessageFetcher *writer)
 {
     if (fd < 0) return;
-    //we expect one NMEA message in one UDP packet
-    buffer->reset();
-    size_t rd=buffer->fillData(buffer->freeSpace(),
-    [this](uint8_t *rcvb,size_t rcvlen,void *param)->size_t{
+    if (readiness && ! readiness->canRead(fd)){
+        //nothing new, but maybe something left from the last loop
+        writer->handleBuffer(buffer);
+        return;
+    }
+    //read all pending datagrams (up to MAX_DATAGRAMS_PER_LOOP)
+    //every datagram is terminated with a newline to keep the message boundaries
+    for (int i=0;i<MAX_DATAGRAMS_PER_LOOP;i++){
         struct sockaddr_in from;
         socklen_t fromLen=sizeof(from);
-        ssize_t res=recvfrom(fd,rcvb,rcvlen,MSG_DONTWAIT,
-        (struct sockaddr*)&from,&fromLen);
-        if (res <= 0) return 0;
-        if (GwSocketHelper::equals(from.sin_addr,apAddr)) return 0;
-        if (!currentStationIp.isEmpty() && (GwSocketHelper::equals(from.sin_addr,staAddr))) return 0;
-        return res;
-    },this);
-    if (buffer->usedSpace() > 0)(GwLog::DEBUG,"UDPR: received %d bytes",buffer->usedSpace());
-    writer->handleBuffer(buffer);   
+        GwSocketReadiness::countCall();
+        ssize_t res=recvfrom(fd,receiveBuffer,MAX_DATAGRAM+1,MSG_DONTWAIT,
+            (struct sockaddr*)&from,&fromLen);
+        if (res < 0){
+            if (errno != EAGAIN && errno != EWOULDBLOCK){
+                socketErrors++;
+                LOG_DEBUG(GwLog::DEBUG,"UDPR: error receiving: %d",errno);
+            }
+            break;
+        }
+        if (GwSocketHelper::equals(from.sin_addr,apAddr)) continue;
+        if (!currentStationIp.isEmpty() && (GwSocketHelper::equals(from.sin_addr,staAddr))) continue;
+        if (res == 0) continue;
+        numDatagrams++;
+        size_t len=res;
+        if (len > MAX_DATAGRAM){
+            truncated++;
+            len=MAX_DATAGRAM;
+        }
+        if (receiveBuffer[len-1] != '\n'){
+            receiveBuffer[len]='\n';
+            len++;
+        }
+        LOG_DEBUG(GwLog::DEBUG+1,"UDPR: received %d bytes",(int)len);
+        if (buffer->freeSpace() < len){
+            //make room by handling what we have
+            writer->handleBuffer(buffer);
+        }
+        if (buffer->addData(receiveBuffer,len) != len){
+            bufferDrops++;
+        }
+    }
+    writer->handleBuffer(buffer);
+}
+long GwUdpReader::getStackDrops(){
+#if LWIP_STATS && UDP_STATS
+    return lwip_stats.udp.drop;
+#else
+    return -1;
+#endif
 }
 size_t GwUdpReader::sendToClients(const char *buf, int source,bool partial)
 { 
@@ -163,4 +200,6 @@ size_t GwUdpReader::sendToClients(const char *buf, int source,bool partial)
 
 GwUdpReader::~GwUdpReader()
 {
+    delete buffer;
+    delete[] receiveBuffer;
 }
\ No newline at end of file
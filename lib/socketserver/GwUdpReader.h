@@ -4,6 +4,7 @@
 #include "GwLog.h"
 #include "GwBuffer.h"
 #include "GwChannelInterface.h"
+#include "GwSocketReadiness.h"
 #include <memory>
 #include <sys/socket.h>
 #include <arpa/inet.h>
@@ -34,12 +35,31 @@ class GwUdpReader: public GwChannelInterface{
         void createAndBind();
         bool setStationAdd(const String &sta);
         GwBuffer *buffer=nullptr;
+        uint8_t *receiveBuffer=nullptr;
+        GwSocketReadiness *readiness=nullptr;
+        unsigned long numDatagrams=0;
+        unsigned long bufferDrops=0;
+        unsigned long truncated=0;
+        unsigned long socketErrors=0;
     public:
+        static const size_t MAX_DATAGRAM=1472;
+        //max number of datagrams we read in one loop
+        static const int MAX_DATAGRAMS_PER_LOOP=20;
         GwUdpReader(const GwConfigHandler *config,GwLog *logger,int minId);
         ~GwUdpReader();
         void begin();
         virtual void loop(bool handleRead=true,bool handleWrite=true);
         virtual size_t sendToClients(const char *buf,int sourceId, bool partialWrite=false);
         virtual void readMessages(GwMessageFetcher *writer);
+        void setReadiness(GwSocketReadiness *r){ readiness=r;}
+        void addFds(GwSocketReadiness *r){ r->addRead(fd);}
+        unsigned long getDatagrams(){ return numDatagrams;}
+        //datagrams dropped as our receive buffer was full
+        unsigned long getBufferDrops(){ return bufferDrops;}
+        //datagrams larger than MAX_DATAGRAM
+        unsigned long getTruncated(){ return truncated;}
+        unsigned long getSocketErrors(){ return socketErrors;}
+        //UDP datagrams dropped by the IP stack (all sockets), -1 if not available
+        static long getStackDrops();
 };
 #endif
\ No newline at end of file
@@ -87,7 +87,12 @@ GwUdpWriter::GwUdpWriter(const GwConfigHandler *config, GwLog *logger, int minId
     this->logger = logger;
     this->minId = minId;
     port=config->getInt(GwConfigDefinitions::udpwPort);
-    
+    pack=config->getBool(GwConfigDefinitions::udpwPack);
+    int cfgMtu=config->getInt(GwConfigDefinitions::udpwMtu,1400);
+    if (cfgMtu < 100) cfgMtu=100;
+    mtu=cfgMtu;
+    int cfgFlush=config->getInt(GwConfigDefinitions::udpwFlush,20);
+    flushTime=cfgFlush > 0?cfgFlush:1;
 }
 void GwUdpWriter::checkStaSocket(){
     String src;
@@ -138,7 +143,11 @@ void GwUdpWriter::begin()
 {
     if (type != T_UNKNOWN) return; //already started
     type=(UType)(config->getInt(GwConfigDefinitions::udpwType));
-    LOG_INFO("UDPW begin, mode=%d",(int)type);
+    LOG_INFO("UDPW begin, mode=%d, pack=%d, mtu=%d, flush=%lums",(int)type,(int)pack,(int)mtu,flushTime);
+    if (pack){
+        packBuffer=new char[mtu];
+        packFill=0;
+    }
     String src=WiFi.softAPIP().toString();
     String dst;
     WriterSocket::SourceMode sm=WriterSocket::SourceMode::S_UNBOUND;
@@ -168,36 +177,86 @@ void GwUdpWriter::begin()
     checkStaSocket();
 }
 
+void GwUdpWriter::updateRates(unsigned long now){
+    if (windowStart == 0){
+        windowStart=now;
+        return;
+    }
+    unsigned long diff=now-windowStart;
+    if (diff < 1000) return;
+    float seconds=(float)diff/1000.0;
+    sentenceRate=(float)windowSentences/seconds;
+    datagramRate=(float)windowDatagrams/seconds;
+    windowSentences=0;
+    windowDatagrams=0;
+    windowStart=now;
+}
+
 void GwUdpWriter::loop(bool handleRead, bool handleWrite)
 {
     if (handleWrite){
         checkStaSocket();
+        if (packFill > 0 && (millis()-packStart) >= flushTime){
+            flush();
+        }
     }
-    
+    updateRates(millis());
 }
 
 void GwUdpWriter::readMessages(GwMessageFetcher *writer)
 {
     
 }
-size_t GwUdpWriter::sendToClients(const char *buf, int source,bool partial)
-{ 
-    if (source == minId) return 0;
-    size_t len=strlen(buf);
+size_t GwUdpWriter::sendDatagram(const char *buf,size_t len){
     bool hasSent=false;
     size_t res=0;
     if (apSocket != nullptr){
         res=apSocket->send(buf,len);
-        if (res > 0) hasSent=true;
+        if (res > 0){
+            hasSent=true;
+            datagrams++;
+            windowDatagrams++;
+        }
     }
     if (staSocket != nullptr){
         res=staSocket->send(buf,len);
-        if (res > 0) hasSent=true;
+        if (res > 0){
+            hasSent=true;
+            datagrams++;
+            windowDatagrams++;
+        }
     }
     return hasSent?len:0;
 }
+void GwUdpWriter::flush(){
+    if (packFill == 0) return;
+    sendDatagram(packBuffer,packFill);
+    packFill=0;
+}
+size_t GwUdpWriter::sendToClients(const char *buf, int source,bool partial)
+{ 
+    if (source == minId) return 0;
+    if (apSocket == nullptr && staSocket == nullptr) return 0;
+    size_t len=strlen(buf);
+    sentences++;
+    windowSentences++;
+    if (! pack || packBuffer == nullptr){
+        return sendDatagram(buf,len);
+    }
+    if ((packFill+len) > mtu){
+        flush();
+    }
+    if (len > mtu){
+        return sendDatagram(buf,len);
+    }
+    if (packFill == 0) packStart=millis();
+    memcpy(packBuffer+packFill,buf,len);
+    packFill+=len;
+    return len;
+}
 
 
 GwUdpWriter::~GwUdpWriter()
 {
+    delete[] packBuffer;
 }
@@ -62,6 +62,28 @@ class GwUdpWriter: public GwChannelInterface{
         int port;
         UType type=T_UNKNOWN;
         void checkStaSocket();
+        /**
+         * packing of multiple messages into one datagram
+         */
+        bool pack=false;
+        size_t mtu=1400;
+        unsigned long flushTime=20;
+        char *packBuffer=nullptr;
+        size_t packFill=0;
+        unsigned long packStart=0;
+        size_t sendDatagram(const char *buf,size_t len);
+        void flush();
+        /**
+         * statistics, rates over 1s
+         */
+        unsigned long sentences=0;
+        unsigned long datagrams=0;
+        unsigned long windowStart=0;
+        unsigned long windowSentences=0;
+        unsigned long windowDatagrams=0;
+        float sentenceRate=0;
+        float datagramRate=0;
+        void updateRates(unsigned long now);
     public:
         GwUdpWriter(const GwConfigHandler *config,GwLog *logger,int minId);
         ~GwUdpWriter();
@@ -69,5 +91,9 @@ class GwUdpWriter: public GwChannelInterface{
         virtual void loop(bool handleRead=true,bool handleWrite=true);
         virtual size_t sendToClients(const char *buf,int sourceId, bool partialWrite=false);
         virtual void readMessages(GwMessageFetcher *writer);
+        float getSentenceRate(){ return sentenceRate;}
+        float getDatagramRate(){ return datagramRate;}
+        unsigned long getSentences(){ return sentences;}
+        unsigned long getDatagrams(){ return datagrams;}
 };
 #endif
\ No newline at end of file
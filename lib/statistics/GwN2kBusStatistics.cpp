@@ -0,0 +1,221 @@
+#include "GwN2kBusStatistics.h"
+
+//bits of an extended data frame with 8 data bytes, without stuff bits
+//SOF+ID(11+1+1+18)+RTR+r1+r0+DLC(4)+DATA(64)+CRC(15+1)+ACK(2)+EOF(7)+IFS(3)
+static const uint32_t BITS_PER_FRAME=67+64;
+static const float AVG_FACTOR=0.1;
+
+static inline uint32_t hashKey(uint32_t key){
+    key ^= key >> 16;
+    key *= 0x45d9f3b;
+    key ^= key >> 16;
+    return key;
+}
+
+GwN2kBusStatistics::GwN2kBusStatistics(){
+    sources=new SourceEntry[MAX_SOURCES];
+    pgns=new PgnEntry[MAX_PGNS];
+    flows=new FlowEntry[MAX_FLOWS];
+}
+GwN2kBusStatistics::~GwN2kBusStatistics(){
+    delete[] sources;
+    delete[] pgns;
+    delete[] flows;
+}
+void GwN2kBusStatistics::reset(){
+    for (int i=0;i<MAX_SOURCES;i++) sources[i]=SourceEntry();
+    for (int i=0;i<MAX_PGNS;i++) pgns[i]=PgnEntry();
+    for (int i=0;i<MAX_FLOWS;i++) flows[i]=FlowEntry();
+    total=Counter();
+    winBits=0;
+    utilization=0;
+    windowStart=0;
+    sourceOverflow=0;
+    pgnOverflow=0;
+    flowOverflow=0;
+    numSources=0;
+    numPgns=0;
+    numFlows=0;
+}
+
+uint32_t GwN2kBusStatistics::numFrames(const tN2kMsg &msg){
+    if (msg.DataLen <= 8) return 1;
+    if (msg.DataLen <= 223){
+        //fast packet: 6 bytes in the first frame, 7 in each following
+        return 1 + (msg.DataLen - 6 + 6) / 7;
+    }
+    //ISO multi packet: one BAM/RTS frame + 7 bytes per data frame
+    return 1 + (msg.DataLen + 6) / 7;
+}
+
+GwN2kBusStatistics::SourceEntry *GwN2kBusStatistics::findSource(uint8_t source){
+    uint32_t idx=hashKey(source) % MAX_SOURCES;
+    for (int i=0;i<MAX_SOURCES;i++){
+        SourceEntry *e=&sources[idx];
+        if (e->source == source) return e;
+        if (e->source < 0){
+            e->source=source;
+            numSources++;
+            return e;
+        }
+        idx++;
+        if (idx >= MAX_SOURCES) idx=0;
+    }
+    return nullptr;
+}
+GwN2kBusStatistics::PgnEntry *GwN2kBusStatistics::findPgn(uint32_t pgn){
+    uint32_t idx=hashKey(pgn) % MAX_PGNS;
+    for (int i=0;i<MAX_PGNS;i++){
+        PgnEntry *e=&pgns[idx];
+        if (e->used && e->pgn == pgn) return e;
+        if (! e->used){
+            e->used=true;
+            e->pgn=pgn;
+            numPgns++;
+            return e;
+        }
+        idx++;
+        if (idx >= MAX_PGNS) idx=0;
+    }
+    return nullptr;
+}
+GwN2kBusStatistics::FlowEntry *GwN2kBusStatistics::findFlow(uint8_t source, uint32_t pgn){
+    uint32_t idx=hashKey((pgn << 8) | source) % MAX_FLOWS;
+    for (int i=0;i<MAX_FLOWS;i++){
+        FlowEntry *e=&flows[idx];
+        if (e->source == source && e->pgn == pgn) return e;
+        if (e->source < 0){
+            e->source=source;
+            e->pgn=pgn;
+            numFlows++;
+            return e;
+        }
+        idx++;
+        if (idx >= MAX_FLOWS) idx=0;
+    }
+    return nullptr;
+}
+
+void GwN2kBusStatistics::checkWindow(unsigned long now){
+    if (windowStart == 0){
+        windowStart=now;
+        return;
+    }
+    unsigned long diff=now-windowStart;
+    if (diff < WINDOW_MS) return;
+    float seconds=(float)diff/1000.0;
+    total.closeWindow(seconds);
+    utilization=100.0 * (float)winBits / ((float)BUS_BITRATE * seconds);
+    winBits=0;
+    for (int i=0;i<MAX_SOURCES;i++){
+        if (sources[i].source >= 0) sources[i].closeWindow(seconds);
+    }
+    for (int i=0;i<MAX_PGNS;i++){
+        if (pgns[i].used) pgns[i].closeWindow(seconds);
+    }
+    windowStart=now;
+}
+
+void GwN2kBusStatistics::add(const tN2kMsg &msg){
+    checkWindow(millis());
+    uint32_t frames=numFrames(msg);
+    uint32_t bytes=msg.DataLen;
+    total.add(frames,bytes);
+    winBits+=frames*BITS_PER_FRAME;
+    SourceEntry *source=findSource(msg.Source);
+    if (source) source->add(frames,bytes);
+    else sourceOverflow++;
+    PgnEntry *pgn=findPgn(msg.PGN);
+    if (pgn) pgn->add(frames,bytes);
+    else pgnOverflow++;
+    FlowEntry *flow=findFlow(msg.Source,msg.PGN);
+    if (! flow){
+        flowOverflow++;
+        return;
+    }
+    unsigned long nowUs=micros();
+    if (flow->msgs > 0){
+        float interval=(float)(nowUs-flow->lastUs);
+        if (flow->msgs == 1){
+            flow->interval=interval;
+        }
+        else{
+            float deviation=interval-flow->interval;
+            if (deviation < 0) deviation=-deviation;
+            flow->jitter+=(deviation-flow->jitter)*AVG_FACTOR;
+            flow->interval+=(interval-flow->interval)*AVG_FACTOR;
+        }
+    }
+    flow->lastUs=nowUs;
+    flow->msgs++;
+}
+
+int GwN2kBusStatistics::getJsonSize(){
+    return JSON_OBJECT_SIZE(12) +
+        JSON_OBJECT_SIZE(3) +
+        JSON_OBJECT_SIZE(numSources) + numSources*(JSON_OBJECT_SIZE(5)+5) +
+        JSON_OBJECT_SIZE(numPgns) + numPgns*(JSON_OBJECT_SIZE(5)+8) +
+        JSON_ARRAY_SIZE(numFlows) + numFlows*JSON_OBJECT_SIZE(5) +
+        JSON_ARRAY_SIZE(NUM_TOP);
+}
+
+void GwN2kBusStatistics::toJson(GwJsonDocument &json){
+    checkWindow(millis());
+    json["window"]=WINDOW_MS;
+    json["utilization"]=utilization;
+    json["framesPerS"]=total.frameRate;
+    json["bytesPerS"]=total.byteRate;
+    json["msgs"]=total.msgs;
+    json["frames"]=total.frames;
+    JsonObject overflow=json.createNestedObject("overflow");
+    overflow["sources"]=sourceOverflow;
+    overflow["pgns"]=pgnOverflow;
+    overflow["flows"]=flowOverflow;
+    JsonObject jsources=json.createNestedObject("sources");
+    SourceEntry *top[NUM_TOP];
+    int numTop=0;
+    for (int i=0;i<MAX_SOURCES;i++){
+        SourceEntry *e=&sources[i];
+        if (e->source < 0) continue;
+        JsonObject js=jsources.createNestedObject(String(e->source));
+        js["fps"]=e->frameRate;
+        js["bps"]=e->byteRate;
+        js["msgs"]=e->msgs;
+        js["frames"]=e->frames;
+        js["bytes"]=e->bytes;
+        //insertion sort into the top talkers (by frames/s)
+        int pos=numTop;
+        while (pos > 0 && top[pos-1]->frameRate < e->frameRate) pos--;
+        if (pos >= NUM_TOP) continue;
+        int last=(numTop < NUM_TOP)?numTop:NUM_TOP-1;
+        for (int k=last;k>pos;k--) top[k]=top[k-1];
+        top[pos]=e;
+        if (numTop < NUM_TOP) numTop++;
+    }
+    JsonArray jtop=json.createNestedArray("top");
+    for (int i=0;i<numTop;i++){
+        jtop.add(top[i]->source);
+    }
+    JsonObject jpgns=json.createNestedObject("pgns");
+    for (int i=0;i<MAX_PGNS;i++){
+        PgnEntry *e=&pgns[i];
+        if (! e->used) continue;
+        JsonObject jp=jpgns.createNestedObject(String(e->pgn));
+        jp["fps"]=e->frameRate;
+        jp["bps"]=e->byteRate;
+        jp["msgs"]=e->msgs;
+        jp["frames"]=e->frames;
+        jp["bytes"]=e->bytes;
+    }
+    JsonArray jflows=json.createNestedArray("flows");
+    for (int i=0;i<MAX_FLOWS;i++){
+        FlowEntry *e=&flows[i];
+        if (e->source < 0) continue;
+        JsonObject jf=jflows.createNestedObject();
+        jf["src"]=e->source;
+        jf["pgn"]=e->pgn;
+        jf["msgs"]=e->msgs;
+        jf["interval"]=e->interval/1000.0; //ms
+        jf["jitter"]=e->jitter/1000.0;
+    }
+}
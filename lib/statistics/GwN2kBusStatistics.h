@@ -0,0 +1,93 @@
+#ifndef _GWN2KBUSSTATISTICS_H
+#define _GWN2KBUSSTATISTICS_H
+#include <Arduino.h>
+#include <N2kMsg.h>
+#include "GwJsonDocument.h"
+
+/**
+ * bus analytics for the NMEA2000 side
+ * fed from the receive path with every message we got from the bus
+ * all tables are fixed size and allocated once - no allocations per message
+ * rates are computed over windows of WINDOW_MS
+ */
+class GwN2kBusStatistics{
+    public:
+        static const unsigned long WINDOW_MS=1000;
+        static const unsigned long BUS_BITRATE=250000;
+        static const int MAX_SOURCES=64;
+        static const int MAX_PGNS=128;
+        static const int MAX_FLOWS=256;
+        static const int NUM_TOP=8;
+    private:
+        class Counter{
+            public:
+            uint32_t msgs=0;
+            uint32_t frames=0;
+            uint32_t bytes=0;
+            uint32_t winFrames=0;
+            uint32_t winBytes=0;
+            float frameRate=0;
+            float byteRate=0;
+            void add(uint32_t fr,uint32_t by){
+                msgs++;
+                frames+=fr;
+                bytes+=by;
+                winFrames+=fr;
+                winBytes+=by;
+            }
+            void closeWindow(float seconds){
+                frameRate=(float)winFrames/seconds;
+                byteRate=(float)winBytes/seconds;
+                winFrames=0;
+                winBytes=0;
+            }
+        };
+        class SourceEntry: public Counter{
+            public:
+            int16_t source=-1;
+        };
+        class PgnEntry: public Counter{
+            public:
+            uint32_t pgn=0;
+            bool used=false;
+        };
+        class FlowEntry{
+            public:
+            uint32_t pgn=0;
+            int16_t source=-1;
+            uint32_t msgs=0;
+            unsigned long lastUs=0;
+            float interval=0; //us, moving average
+            float jitter=0;   //us, moving average of the deviation
+        };
+        SourceEntry *sources=nullptr;
+        PgnEntry *pgns=nullptr;
+        FlowEntry *flows=nullptr;
+        Counter total;
+        uint32_t winBits=0;
+        float utilization=0;
+        unsigned long windowStart=0;
+        uint32_t sourceOverflow=0;
+        uint32_t pgnOverflow=0;
+        uint32_t flowOverflow=0;
+        int numSources=0;
+        int numPgns=0;
+        int numFlows=0;
+        SourceEntry *findSource(uint8_t source);
+        PgnEntry *findPgn(uint32_t pgn);
+        FlowEntry *findFlow(uint8_t source,uint32_t pgn);
+        void checkWindow(unsigned long now);
+    public:
+        GwN2kBusStatistics();
+        ~GwN2kBusStatistics();
+        /**
+         * number of CAN frames used to transport a message
+         * single frame, fast packet or ISO multi packet
+         */
+        static uint32_t numFrames(const tN2kMsg &msg);
+        void add(const tN2kMsg &msg);
+        void reset();
+        int getJsonSize();
+        void toJson(GwJsonDocument &json);
+};
+#endif
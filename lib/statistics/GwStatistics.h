@@ -2,6 +2,8 @@
 #include <Arduino.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
+#include <esp_timer.h>
+#include "GwJsonDocument.h"
 
 static inline int64_t gwMonotonicUs(){
   TickType_t ticks=xTaskGetTickCount();
@@ -130,3 +132,45 @@ class TimeMonitor{
       times[index]->add(currentv);
     }
 };
+
+/**
+ * boot phase timing
+ * mark is called at the end of each phase in setup
+ * the time of a phase is the time since the previous mark (us)
+ * the first phase is the time from power up until the first mark
+ */
+class GwBootTimer{
+  public:
+    static const int MAX_PHASES=16;
+  private:
+    const char *names[MAX_PHASES];
+    int64_t times[MAX_PHASES];
+    int numPhases=0;
+    int64_t last=0;
+    int64_t firstN2k=0;
+  public:
+    void mark(const char *name){
+      int64_t now=esp_timer_get_time();
+      if (numPhases >= MAX_PHASES) return;
+      names[numPhases]=name;
+      times[numPhases]=now-last;
+      numPhases++;
+      last=now;
+    }
+    //first message received from the bus
+    void n2kReceived(){
+      if (firstN2k != 0) return;
+      firstN2k=esp_timer_get_time();
+    }
+    int getJsonSize(){
+      return JSON_OBJECT_SIZE(MAX_PHASES+2);
+    }
+    void toJson(GwJsonDocument &json){
+      JsonObject jo=json.createNestedObject("boot");
+      for (int i=0;i<numPhases;i++){
+        jo[names[i]]=(unsigned long)times[i];
+      }
+      jo["total"]=(unsigned long)last;
+      jo["firstN2k"]=(unsigned long)firstN2k;
+    }
+};
@@ -62,15 +62,18 @@ const unsigned long HEAP_REPORT_TIME=2000; //set to 0 to disable heap reporting
 #include "GwSynchronized.h"
 #include "GwUserCode.h"
 #include "GwStatistics.h"
+#include "GwN2kBusStatistics.h"
 #include "GwUpdate.h"
 #include "GwTcpClient.h"
 #include "GwChannel.h"
 #include "GwChannelList.h"
 #include "GwTimer.h"
+#include "GwAisTargets.h"
+#include "GwDerivedData.h"
 
 
-#define MAX_NMEA2000_MESSAGE_SEASMART_SIZE 500
-#define MAX_NMEA0183_MESSAGE_SIZE MAX_NMEA2000_MESSAGE_SEASMART_SIZE
+//same limit as the seasmart encoding of N2K messages
+#define MAX_NMEA0183_MESSAGE_SIZE GwN2kEncodings::MAX_SEASMART_SIZE
 //assert length of firmware name and version
 CASSERT(strlen(FIRMWARE_TYPE) <= 31, "environment name (FIRMWARE_TYPE) must not exceed 32 chars");
 CASSERT(strlen(VERSION) <= 31, "VERSION must not exceed 32 chars");
@@ -113,6 +116,11 @@ class Nmea2kTwaiLog : public Nmea2kTwai{
       va_start(args,fmt);
       if (level > 2) level++; //error+info+debug are similar, map msg to 4
       logger->logDebug(level,fmt,args);
+      va_end(args);
+    }
+    virtual bool isLogActive(int level){
+      if (level > 2) level++;
+      return logger->isActive(level);
     }
 };
 
@@ -156,6 +164,11 @@ GwWebServer webserver(&logger,&mainQueue,80);
 
 GwCounter<unsigned long> countNMEA2KIn("countNMEA2000in");
 GwCounter<unsigned long> countNMEA2KOut("countNMEA2000out");
+GwN2kBusStatistics n2kBusStatistics;
+GwBootTimer bootTimer;
+GwAisTargets aisTargets;
+//AIS thinning for the messages we send to the NMEA2000 bus
+GwAisThinner n2kAisThinner;
 GwIntervalRunner timers;
 
 bool checkPass(String hash){
@@ -169,40 +182,33 @@ GwConfigInterface *systemName=config.getConfigItem(config.systemName,true);
 
 void handleN2kMessage(const tN2kMsg &n2kMsg,int sourceId, bool isConverted=false)
 {
-  logger.logDebug(GwLog::DEBUG + 1, "N2K: pgn %d, dir %d", 
+  GW_LOG(logger,GwLog::DEBUG + 1, "N2K: pgn %d, dir %d", 
     n2kMsg.PGN,sourceId);
   if (sourceId == N2K_CHANNEL_ID){
     countNMEA2KIn.add(n2kMsg.PGN);
+    n2kBusStatistics.add(n2kMsg);
+    bootTimer.n2kReceived();
   }
-  char *buf=new char[MAX_NMEA2000_MESSAGE_SEASMART_SIZE+3];
-  std::unique_ptr<char> bufDel(buf);
-  bool messageCreated=false;
+  aisTargets.handleMessage(n2kMsg);
+  GwAisTargets::ThinInfo aisInfo=aisTargets.getThinInfo(n2kMsg);
+  //encode at most once per message and share the result between all channels
+  GwN2kEncodings encodings(n2kMsg,sourceId == N2K_CHANNEL_ID);
   channels.allChannels([&](GwChannel *c){
-    if (c->sendSeaSmart()){
-      if (! messageCreated){
-        size_t len;
-        if ((len=N2kToSeasmart(n2kMsg, millis(), buf, MAX_NMEA2000_MESSAGE_SEASMART_SIZE)) != 0) {
-          buf[len]=0x0d;
-          len++;
-          buf[len]=0x0a;
-          len++;
-          buf[len]=0;
-          messageCreated=true;
-        }
-      }
-      if (messageCreated){
-        c->sendToClients(buf,sourceId,true);
+    if (c->sendSeaSmart(n2kMsg.PGN)){
+      const char *buf=encodings.getString(GwN2kEncodings::SEASMART);
+      if (buf){
+        c->sendToClients(buf,sourceId,true,&aisInfo);
       }
     }
   });
   
   channels.allChannels([&](GwChannel *c){
-    c->sendActisense(n2kMsg,sourceId);
+    c->sendN2k(encodings,sourceId,&aisInfo);
   });
   if (! isConverted){
     nmea0183Converter->HandleMsg(n2kMsg,sourceId);
   }
-  if (sourceId != N2K_CHANNEL_ID && sendOutN2k){
+  if (sourceId != N2K_CHANNEL_ID && sendOutN2k && n2kAisThinner.canPass(aisInfo)){
     if (NMEA2000.SendMsg(n2kMsg)){
       countNMEA2KOut.add(n2kMsg.PGN);
     }
@@ -215,11 +221,11 @@ void handleN2kMessage(const tN2kMsg &n2kMsg,int sourceId, bool isConverted=false
 
 //*****************************************************************************
 void SendNMEA0183Message(const tNMEA0183Msg &NMEA0183Msg, int sourceId,bool convert=false) {
-  logger.logDebug(GwLog::DEBUG+2,"SendNMEA0183(1)");
+  GW_LOG(logger,GwLog::DEBUG+2,"SendNMEA0183(1)");
   char *buf=new char[MAX_NMEA0183_MESSAGE_SIZE+3];
   std::unique_ptr<char> bufDel(buf);
   if ( !NMEA0183Msg.GetMessage(buf, MAX_NMEA0183_MESSAGE_SIZE) ) return;
-  logger.logDebug(GwLog::DEBUG+2,"SendNMEA0183: %s",buf);
+  GW_LOG(logger,GwLog::DEBUG+2,"SendNMEA0183: %s",buf);
   if (convert){
     toN2KConverter->parseAndSend(buf,sourceId);
   }
@@ -227,11 +233,21 @@ void SendNMEA0183Message(const tNMEA0183Msg &NMEA0183Msg, int sourceId,bool conv
   buf[len]=0x0d;
   buf[len+1]=0x0a;
   buf[len+2]=0;
+  GwAisTargets::ThinInfo aisInfo=aisTargets.getThinInfo(buf);
   channels.allChannels([&](GwChannel *c){
-    c->sendToClients(buf,sourceId,false);
+    c->sendToClients(buf,sourceId,false,&aisInfo);
   });
 }
 
+GwDerivedData derivedData(&logger,&boatData,DERIVED_CHANNEL_ID,
+  [](const tN2kMsg &msg,int sourceId){
+    //we send our own 0183 messages, no conversion
+    handleN2kMessage(msg,sourceId,true);
+  },
+  [](const tNMEA0183Msg &msg,int sourceId){
+    SendNMEA0183Message(msg,sourceId,false);
+  });
+
 class CalibrationValues {
   using Map=std::map<String,double>;
   Map values;
@@ -412,11 +428,14 @@ public:
 protected:
   virtual void processRequest()
   {
-    GwJsonDocument status(305 + 
+    GwJsonDocument status(321 + JSON_OBJECT_SIZE(2) +
       countNMEA2KIn.getJsonSize()+
       countNMEA2KOut.getJsonSize() +
       channels.getJsonSize()+
-      userCodeHandler.getJsonSize()
+      toN2KConverter->getJsonSize()+
+      GwDerivedData::getJsonSize()+
+      userCodeHandler.getJsonSize()+
+      bootTimer.getJsonSize()
       );
     status["version"] = VERSION;
     status["wifiConnected"] = gwWifi.clientConnected();
@@ -445,15 +464,52 @@ protected:
     status["n2kstate"]=NMEA2000.stateStr(driverState);
     status["n2knode"]=NodeAddress;
     status["minUser"]=MIN_USER_TASK;
+    status["logDropped"]=logger.getDropped();
+    if (n2kAisThinner.isActive()){
+      JsonObject aisThin=status.createNestedObject("aisThinN2k");
+      aisThin["forwarded"]=n2kAisThinner.getForwarded();
+      aisThin["suppressed"]=n2kAisThinner.getSuppressed();
+    }
     //nmea0183Converter->toJson(status);
     countNMEA2KIn.toJson(status);
     countNMEA2KOut.toJson(status);
     channels.toJson(status);
+    toN2KConverter->toJson(status);
+    derivedData.toJson(status);
     userCodeHandler.fillStatus(status);
+    bootTimer.toJson(status);
     serializeJson(status, result);
   }
 };
 
+class N2kStatsRequest : public GwRequestMessage
+{
+public:
+  N2kStatsRequest() : GwRequestMessage(F("application/json"),F("n2kStats")){};
+
+protected:
+  virtual void processRequest()
+  {
+    GwJsonDocument json(n2kBusStatistics.getJsonSize()+
+      GwN2kEncodings::getJsonSize());
+    n2kBusStatistics.toJson(json);
+    GwN2kEncodings::toJson(json);
+    serializeJson(json, result);
+  }
+};
+
+class LogRequest : public GwRequestMessage
+{
+public:
+  LogRequest() : GwRequestMessage(F("text/plain"),F("log")){};
+
+protected:
+  virtual void processRequest()
+  {
+    result = logger.getTail();
+  }
+};
+
 class CheckPassRequest : public GwRequestMessage{
   String hash;
   public:
@@ -570,6 +626,53 @@ protected:
     result = boatData.toString();
   }
 };
+class BoatDataBinRequest : public GwRequestMessage
+{
+  unsigned long since;
+  bool withSchema;
+public:
+  BoatDataBinRequest(unsigned long since, bool withSchema) : 
+    GwRequestMessage(F("application/msgpack"),F("boatDataBin")),since(since),withSchema(withSchema){
+      binary=true;
+    };
+
+protected:
+  virtual void processRequest()
+  {
+    boatData.toBinary(binaryResult,since,withSchema || since == 0);
+  }
+};
+
+class AisTargetsRequest : public GwRequestMessage
+{
+  unsigned long since;
+  int maxTargets;
+  int start;
+public:
+  AisTargetsRequest(unsigned long since, int maxTargets, int start) : 
+    GwRequestMessage(F("application/json"),F("aisTargets")),since(since),maxTargets(maxTargets),start(start){};
+
+protected:
+  virtual void processRequest()
+  {
+    result = aisTargets.toJson(since,maxTargets,start);
+  }
+};
+class AisTargetsBinRequest : public GwRequestMessage
+{
+  unsigned long since;
+public:
+  AisTargetsBinRequest(unsigned long since) : 
+    GwRequestMessage(F("application/msgpack"),F("aisTargetsBin")),since(since){
+      binary=true;
+    };
+
+protected:
+  virtual void processRequest()
+  {
+    aisTargets.toBinary(binaryResult,since);
+  }
+};
 
 class XdrExampleRequest : public GwRequestMessage
 {
@@ -621,7 +724,6 @@ void handleConfigRequestData(AsyncWebServerRequest *request, uint8_t *data, size
     int bValue;
     char value[512];
   }RequestNV;
-  long long lastRecords=logger.getRecordCounter();
   logger.logDebug(GwLog::DEBUG,"handleConfigRequestData len=%d,idx=%d,total=%d",(int)len,(int)index,(int)total);
   if (request->_tempObject == NULL){
     logger.logDebug(GwLog::DEBUG,"handleConfigRequestData create receive struct");
@@ -702,16 +804,14 @@ void handleConfigRequestData(AsyncWebServerRequest *request, uint8_t *data, size
           }
           else{
             nv->hashChecked=1;
+            config.beginUpdate();
           }
         }
         else{
           if (nv->hashChecked){
             logger.logDebug(GwLog::DEBUG,"value ns=%d,n=%s,vs=%d,v=%s",nv->bName,nv->name,nv->bValue,nv->value);
-            if ((logger.getRecordCounter() - lastRecords) > 20){
-              logger.flush();
-              lastRecords=logger.getRecordCounter();
-            }
-            config.updateValue(request->urlDecode(name),request->urlDecode(value));
+            //only staged here, written in one go at the end
+            config.stageValue(request->urlDecode(name),request->urlDecode(value));
           }
         }
         nv->parsingValue=0;
@@ -723,14 +823,32 @@ void handleConfigRequestData(AsyncWebServerRequest *request, uint8_t *data, size
   if (parsed >= len && (len+index)>= total){
     if (nv->notFirst){
       if (nv->hashChecked){
-        request->send(200,"application/json",JSON_OK);
+        GwConfigHandler::UpdateResult res=config.commitUpdate();
+        String rt;
+        String status="OK";
+        if (res.invalid > 0){
+          status=String("ERROR: invalid value for ")+res.firstInvalid;
+        }
+        else if (! res.ok){
+          status="ERROR: unable to write config";
+        }
+        //the status string is copied into the document
+        GwJsonDocument json(JSON_OBJECT_SIZE(6)+status.length()+1);
+        json["status"]=status;
+        json["changed"]=res.staged;
+        json["unknown"]=res.unknown;
+        json["invalid"]=res.invalid;
+        json["writes"]=res.writes;
+        json["us"]=res.us;
+        serializeJson(json,rt);
+        request->send(200,"application/json",rt);
         logger.flush();
         logger.logDebug(GwLog::DEBUG,"Heap free=%ld, minFree=%ld",
           (long)xPortGetFreeHeapSize(),
           (long)xPortGetMinimumEverFreeHeapSize()
         );
         logger.flush();
-        delayedRestart();
+        if (res.ok) delayedRestart();
       }
     }
     else{
@@ -771,11 +889,26 @@ void loopFunction(void *){
   }
 }
 const String USERPREFIX="/api/user/";
+//random per boot, part of the ETags for data that is fixed after setup
+static uint32_t bootId=0;
+static String staticEtag(){
+  char buffer[12];
+  snprintf(buffer,sizeof(buffer),"\"%08lx\"",(unsigned long)bootId);
+  return String(buffer);
+}
+static String configEtag(){
+  char buffer[24];
+  snprintf(buffer,sizeof(buffer),"\"%08lx-%lu\"",(unsigned long)bootId,config.getGeneration());
+  return String(buffer);
+}
 void setup() {
   mainLock=xSemaphoreCreateMutex();
   uint8_t chipid[6];
   uint32_t id = 0;
+  bootTimer.mark("preSetup");
+  bootId=esp_random();
   config.loadConfig();
+  bootTimer.mark("config");
   int level=config.getInt(config.logLevel,LOGLEVEL);
   logger.setLevel(level);
   bool fallbackSerial=false;
@@ -791,36 +924,78 @@ void setup() {
   userCodeHandler.begin(mainLock);
   userCodeHandler.startInitTasks(MIN_USER_TASK);
   channels.preinit();
+  bootTimer.mark("userInit");
   config.stopChanges();
   //maybe the user code changed the level
   level=config.getInt(config.logLevel,LOGLEVEL);
   logger.setLevel(level);
   sendOutN2k=config.getBool(config.sendN2k,true);
   logger.logDebug(GwLog::LOG,"send N2k=%s",(sendOutN2k?"true":"false"));
+  aisTargets.setThinning(config.getInt(config.aisThinInterval,30)*1000UL,
+    config.getInt(config.aisThinTcpa,20)*60.0);
+  n2kAisThinner.setRange(config.getString(config.n2kAisThin).toFloat());
+  derivedData.begin(&config);
   gwWifi.setup();
+  bootTimer.mark("wifi");
   MDNS.begin(config.getConfigItem(config.systemName)->asCString());
+  bootTimer.mark("mdns");
   channels.begin(fallbackSerial);
+  bootTimer.mark("channels");
   logger.flush();
+  logger.startAsync();
   config.logConfig(GwLog::DEBUG);
   webserver.registerMainHandler("/api/reset", [](AsyncWebServerRequest *request)->GwRequestMessage *{
     return new ResetRequest(request->arg("_hash"));
   });
   webserver.registerMainHandler("/api/capabilities", [](AsyncWebServerRequest *request)->GwRequestMessage *{
     return new CapabilitiesRequest();
-  });
+  },staticEtag);
   webserver.registerMainHandler("/api/converterInfo", [](AsyncWebServerRequest *request)->GwRequestMessage *{
     return new ConverterInfoRequest();
-  });
+  },staticEtag);
   webserver.registerMainHandler("/api/status", [](AsyncWebServerRequest *request)->GwRequestMessage *
                               { return new StatusRequest(); });
+  webserver.registerMainHandler("/api/n2kStats", [](AsyncWebServerRequest *request)->GwRequestMessage *
+                              { return new N2kStatsRequest(); });
+  webserver.registerMainHandler("/api/log", [](AsyncWebServerRequest *request)->GwRequestMessage *
+                              { return new LogRequest(); });
   webserver.registerMainHandler("/api/config", [](AsyncWebServerRequest *request)->GwRequestMessage *
-                              { return new ConfigRequest(); });
+                              { return new ConfigRequest(); },configEtag);
   webserver.registerMainHandler("/api/resetConfig", [](AsyncWebServerRequest *request)->GwRequestMessage *
                               { return new ResetConfigRequest(request->arg("_hash")); });
   webserver.registerMainHandler("/api/boatData", [](AsyncWebServerRequest *request)->GwRequestMessage *
                               { return new BoatDataRequest(); });
   webserver.registerMainHandler("/api/boatDataString", [](AsyncWebServerRequest *request)->GwRequestMessage *
                               { return new BoatDataStringRequest(); });                              
+  webserver.registerMainHandler("/api/boatDataBin", [](AsyncWebServerRequest *request)->GwRequestMessage *
+                              { 
+                                unsigned long since=strtoul(request->arg("since").c_str(),nullptr,10);
+                                bool withSchema=request->hasArg("schema");
+                                return new BoatDataBinRequest(since,withSchema); 
+                              });
+  webserver.registerMainHandler("/api/aisTargets", [](AsyncWebServerRequest *request)->GwRequestMessage *
+                              { 
+                                unsigned long since=strtoul(request->arg("since").c_str(),nullptr,10);
+                                int maxTargets=GwAisTargets::JSON_PAGE;
+                                if (request->hasArg("max")){
+                                  char *end=nullptr;
+                                  long v=strtol(request->arg("max").c_str(),&end,10);
+                                  if (end != nullptr && *end == 0 && v > 0){
+                                    maxTargets=(v > GwAisTargets::MAX_JSON_PAGE)?GwAisTargets::MAX_JSON_PAGE:v;
+                                  }
+                                }
+                                int start=0;
+                                if (request->hasArg("start")){
+                                  long v=strtol(request->arg("start").c_str(),nullptr,10);
+                                  if (v > 0) start=(v > GwAisTargets::MAX_TARGETS)?GwAisTargets::MAX_TARGETS:v;
+                                }
+                                return new AisTargetsRequest(since,maxTargets,start); 
+                              });
+  webserver.registerMainHandler("/api/aisTargetsBin", [](AsyncWebServerRequest *request)->GwRequestMessage *
+                              { 
+                                unsigned long since=strtoul(request->arg("since").c_str(),nullptr,10);
+                                return new AisTargetsBinRequest(since); 
+                              });
   webserver.registerMainHandler("/api/xdrExample", [](AsyncWebServerRequest *request)->GwRequestMessage *
                               { 
                                 String mapping=request->arg("mapping");
@@ -858,7 +1033,9 @@ void setup() {
   });
 
   webserver.begin();
+  bootTimer.mark("web");
   xdrMappings.begin();
+  bootTimer.mark("xdr");
   logger.flush();
   GwConverterConfig converterConfig;
   converterConfig.init(&config,&logger);
@@ -873,13 +1050,14 @@ void setup() {
     );
 
   toN2KConverter= NMEA0183DataToN2K::create(&logger,&boatData,[](const tN2kMsg &msg, int sourceId)->bool{
-    logger.logDebug(GwLog::DEBUG+2,"send N2K %ld",msg.PGN);
+    GW_LOG(logger,GwLog::DEBUG+2,"send N2K %ld",msg.PGN);
     handleN2kMessage(msg,sourceId,true);
     return true;
   },
   &xdrMappings,
   converterConfig
   );  
+  bootTimer.mark("converters");
   
   NMEA2000.SetN2kCANMsgBufSize(8);
   NMEA2000.SetN2kCANReceiveFrameBufSize(250);
@@ -936,12 +1114,20 @@ void setup() {
     handleN2kMessage(n2kMsg,N2K_CHANNEL_ID);
   });
   NMEA2000.Open();
+  bootTimer.mark("n2k");
   logger.logDebug(GwLog::LOG,"starting addon tasks");
   logger.flush();
   {
     GWSYNCHRONIZED(mainLock);
     userCodeHandler.startUserTasks(MIN_USER_TASK);
   }
+  bootTimer.mark("userTasks");
+  timers.addAction(1000,[](){
+    aisTargets.update(&boatData);
+  });
+  timers.addAction(500,[](){
+    derivedData.update();
+  });
   timers.addAction(HEAP_REPORT_TIME,[](){
     if (logger.isActive(GwLog::DEBUG)){
       logger.logDebug(GwLog::DEBUG,"Heap free=%ld, minFree=%ld",
@@ -979,6 +1165,7 @@ void loopRun() {
   monitor.setTime(3);
   NMEA2000.loop();
   monitor.setTime(4);
+  channels.checkReadiness();
   channels.allChannels([](GwChannel *c){
     c->loop(true,false);
   });
@@ -1011,9 +1198,10 @@ void loopRun() {
       if (strlen(buffer) > 6 && strncmp(buffer,"$PCDIN",6) == 0){
         isSeasmart=true;
       }
+      GwAisTargets::ThinInfo aisInfo;
+      if (! isSeasmart) aisInfo=aisTargets.getThinInfo(buffer);
       channels.allChannels([&](GwChannel *oc){
-        oc->sendToClients(buffer,sourceId,isSeasmart);
-        oc->loop(false,true);
+        oc->sendToClients(buffer,sourceId,isSeasmart,&aisInfo);
       });
       if (c->sendToN2K()){
         if (isSeasmart){
@@ -1036,6 +1224,11 @@ void loopRun() {
     });
   });
   monitor.setTime(10);
+  //write out everything we collected in this loop
+  channels.allChannels([](GwChannel *c){
+    c->loop(false,true);
+  });
+  monitor.setTime(11);
 
   //handle message requests
   GwMessage *msg=mainQueue.fetchMessage(0);
@@ -1043,7 +1236,7 @@ void loopRun() {
     msg->process();
     msg->unref();
   }
-  monitor.setTime(11);
+  monitor.setTime(12);
   //logger.logDebug(GwLog::DEBUG,"main loop end");
 }
 
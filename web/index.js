@@ -647,6 +647,9 @@
         if (configItem.type === 'filter') {
             return createFilterInput(configItem, frame, clazz);
         }
+        if (configItem.type === 'pgnfilter') {
+            return createPgnFilterInput(configItem, frame, clazz);
+        }
         if (configItem.type === 'xdr') {
             return createXdrInput(configItem, frame, clazz);
         }
@@ -963,6 +966,44 @@
         if (configItem.readOnly) data.setAttribute('disabled', true);
         return data;
     }
+    function createPgnFilterInput(configItem, frame) {
+        let el = addEl('div', 'filter', frame);
+        let mode = createInput({
+            type: 'list',
+            name: configItem.name + "_mode",
+            list: ['whitelist', 'blacklist'],
+            readOnly: configItem.readOnly
+        }, el);
+        let pgns = createInput({
+            type: 'text',
+            name: configItem.name + "_pgns",
+            readOnly: configItem.readOnly
+        }, el);
+        let data = addEl('input', undefined, el);
+        data.setAttribute('type', 'hidden');
+        let changeFunction = function () {
+            let cv = data.value || "";
+            let parts = cv.split(":");
+            mode.value = (parts[0] == '0') ? "whitelist" : "blacklist";
+            pgns.value = parts[1] || "";
+        }
+        let updateFunction = function () {
+            let nv = (mode.value == 'blacklist') ? "1" : "0";
+            nv += ":";
+            nv += pgns.value.replace(/[^0-9,]/g, '');
+            data.value = nv;
+            let chev = new Event('change');
+            data.dispatchEvent(chev);
+        }
+        mode.addEventListener('change', updateFunction);
+        pgns.addEventListener("change", updateFunction);
+        data.addEventListener('change', function (ev) {
+            changeFunction();
+        });
+        data.setAttribute('name', configItem.name);
+        if (configItem.readOnly) data.setAttribute('disabled', true);
+        return data;
+    }
     let moreicons = ['icon-more', 'icon-less'];
 
     function collapseCategories(parent, expand) {